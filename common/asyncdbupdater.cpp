@@ -3,18 +3,23 @@
 #include <limits>
 #include <hiredis/hiredis.h>
 #include <pthread.h>
+#include <unordered_map>
 #include "asyncdbupdater.h"
 #include "dbconnector.h"
 #include "redisselect.h"
 #include "redisapi.h"
 #include "table.h"
+#include "redispipeline.h"
+#include "binaryserializer.h"
 
 using namespace std;
 
 namespace swss {
 
 AsyncDBUpdater::AsyncDBUpdater(DBConnector *db, const std::string &tableName)
-    : m_db(db)
+    : m_inflight(0)
+    , m_maxQueueSize(0)
+    , m_db(db)
     , m_tableName(tableName)
 {
     m_runThread = true;
@@ -25,10 +30,14 @@ AsyncDBUpdater::AsyncDBUpdater(DBConnector *db, const std::string &tableName)
 
 AsyncDBUpdater::~AsyncDBUpdater()
 {
-    m_runThread = false;
+    {
+        std::lock_guard<std::mutex> lock(m_dbUpdateDataQueueMutex);
+        m_runThread = false;
+    }
 
     // notify db update thread exit
     m_dbUpdateDataNotifyCv.notify_all();
+    m_queueSpaceCv.notify_all();
     m_dbUpdateThread->join();
     SWSS_LOG_DEBUG("AsyncDBUpdater dtor tableName: %s", m_tableName.c_str());
 }
@@ -36,13 +45,59 @@ AsyncDBUpdater::~AsyncDBUpdater()
 void AsyncDBUpdater::update(std::shared_ptr<KeyOpFieldsValuesTuple> pkco)
 {
     {
-        std::lock_guard<std::mutex> lock(m_dbUpdateDataQueueMutex);
-        m_dbUpdateDataQueue.push(pkco);
+        std::unique_lock<std::mutex> lock(m_dbUpdateDataQueueMutex);
+        waitQueueSpace(lock);
+        m_dbUpdateDataQueue.push_back({ pkco, nullptr, nullptr });
+    }
+
+    m_dbUpdateDataNotifyCv.notify_all();
+}
+
+void AsyncDBUpdater::update(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &pkcos)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_dbUpdateDataQueueMutex);
+        waitQueueSpace(lock);
+        for (auto &pkco : pkcos)
+        {
+            m_dbUpdateDataQueue.push_back({ pkco, nullptr, nullptr });
+        }
     }
 
     m_dbUpdateDataNotifyCv.notify_all();
 }
 
+void AsyncDBUpdater::update(std::shared_ptr<const KcoViewMessage> message)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_dbUpdateDataQueueMutex);
+        waitQueueSpace(lock);
+        for (auto &view : message->kcos)
+        {
+            m_dbUpdateDataQueue.push_back({ nullptr, message, &view });
+        }
+    }
+
+    m_dbUpdateDataNotifyCv.notify_all();
+}
+
+void AsyncDBUpdater::waitQueueSpace(std::unique_lock<std::mutex> &lock)
+{
+    m_queueSpaceCv.wait(lock, [this] {
+        return m_maxQueueSize == 0 || m_dbUpdateDataQueue.size() < m_maxQueueSize || !m_runThread;
+    });
+}
+
+void AsyncDBUpdater::setMaxQueueSize(size_t maxQueueSize)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_dbUpdateDataQueueMutex);
+        m_maxQueueSize = maxQueueSize;
+    }
+
+    m_queueSpaceCv.notify_all();
+}
+
 void AsyncDBUpdater::dbUpdateThread()
 {
     SWSS_LOG_ENTER();
@@ -58,46 +113,97 @@ void AsyncDBUpdater::dbUpdateThread()
 
     // Follow same logic in ConsumerStateTable: every received data will write to 'table'.
     DBConnector db(m_db->getDbName(), 0, true, m_db->getDBKey());
-    Table table(&db, m_tableName);
-    std::mutex cvMutex;
-    std::unique_lock<std::mutex> cvLock(cvMutex);
+    RedisPipeline pipeline(&db);
+    Table table(&pipeline, m_tableName, true);
+    std::string shaReplace = pipeline.loadRedisScript(loadLuaScript("table_replace_hash.lua"));
+
+    std::deque<Update> batch;
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, size_t> lastUpdate;
 
     while (true)
     {
-        size_t count;
-        count = queueSize();
-        if (count == 0)
         {
-            // Check if there still data in queue before exit
-            if (!m_runThread)
+            std::unique_lock<std::mutex> lock(m_dbUpdateDataQueueMutex);
+            m_inflight = 0;
+
+            // when queue is empty, wait notification, data in queue is written before exit
+            m_dbUpdateDataNotifyCv.wait(lock, [this] {
+                return !m_dbUpdateDataQueue.empty() || !m_runThread;
+            });
+
+            if (m_dbUpdateDataQueue.empty())
             {
                 SWSS_LOG_NOTICE("dbUpdateThread for table: %s is exiting", m_tableName.c_str());
                 break;
             }
 
-            // when queue is empty, wait notification, when data come, continue to check queue size again
-            m_dbUpdateDataNotifyCv.wait(cvLock);
-            continue;
-        }
-        else
-        {
+            batch.swap(m_dbUpdateDataQueue);
+            m_inflight = batch.size();
             if (!m_runThread)
             {
-                SWSS_LOG_DEBUG("dbUpdateThread for table: %s still has %d records that need to be sent before exiting", m_tableName.c_str(), (int)count);
+                SWSS_LOG_DEBUG("dbUpdateThread for table: %s still has %d records that need to be sent before exiting", m_tableName.c_str(), (int)m_inflight);
             }
         }
+        m_queueSpaceCv.notify_all();
+
+        // Only the last update of a key is written
+        lastUpdate.clear();
+        keys.clear();
+        for (size_t ie = 0; ie < batch.size(); ie++)
+        {
+            keys.push_back(batch[ie].view ? batch[ie].view->key.str() : kfvKey(*batch[ie].kco));
+            lastUpdate[keys.back()] = ie;
+        }
 
-        for (size_t ie = 0; ie < count; ie++)
+        for (size_t ie = 0; ie < batch.size(); ie++)
         {
-            auto& kco = *(m_dbUpdateDataQueue.front());
+            if (lastUpdate[keys[ie]] != ie)
+            {
+                continue;
+            }
+
+            if (batch[ie].view)
+            {
+                auto& view = *batch[ie].view;
+                if (view.isDel())
+                {
+                    table.del(keys[ie]);
+                    continue;
+                }
+
+                RedisCommand command;
+                command.beginArgv(4 + view.fieldValueCount * 2);
+                command.appendArgv("EVALSHA");
+                command.appendArgv(shaReplace);
+                command.appendArgv("1");
+                command.appendArgv(table.getKeyName(keys[ie]));
+                for (auto& fv : view)
+                {
+                    command.appendArgv(fv.first.data, fv.first.size);
+                    command.appendArgv(fv.second.data, fv.second.size);
+                }
+                pipeline.push(command, REDIS_REPLY_NIL);
+                continue;
+            }
 
+            auto& kco = *batch[ie].kco;
             if (kfvOp(kco) == SET_COMMAND)
             {
+                // Replace the whole entry, because Table::set() does not remove the no longer existed fields from entry.
                 auto& values = kfvFieldsValues(kco);
-
-                // Delete entry before Table::set(), because Table::set() does not remove the no longer existed fields from entry.
-                table.del(kfvKey(kco));
-                table.set(kfvKey(kco), values);
+                RedisCommand command;
+                command.beginArgv(4 + values.size() * 2);
+                command.appendArgv("EVALSHA");
+                command.appendArgv(shaReplace);
+                command.appendArgv("1");
+                command.appendArgv(table.getKeyName(kfvKey(kco)));
+                for (auto& fv : values)
+                {
+                    command.appendArgv(fvField(fv));
+                    command.appendArgv(fvValue(fv));
+                }
+                pipeline.push(command, REDIS_REPLY_NIL);
             }
             else if (kfvOp(kco) == DEL_COMMAND)
             {
@@ -107,12 +213,10 @@ void AsyncDBUpdater::dbUpdateThread()
             {
                 SWSS_LOG_ERROR("db: %s, table: %s receive unknown operation: %s", m_db->getDbName().c_str(), m_tableName.c_str(), kfvOp(kco).c_str());
             }
-
-            {
-                std::lock_guard<std::mutex> lock(m_dbUpdateDataQueueMutex);
-                m_dbUpdateDataQueue.pop();
-            }
         }
+
+        pipeline.flush();
+        batch.clear();
     }
 
     SWSS_LOG_DEBUG("AsyncDBUpdater dbUpdateThread end: %s", m_tableName.c_str());
@@ -123,7 +227,7 @@ size_t AsyncDBUpdater::queueSize()
     // size() is not thread safe
     std::lock_guard<std::mutex> lock(m_dbUpdateDataQueueMutex);
 
-    return m_dbUpdateDataQueue.size();
+    return m_dbUpdateDataQueue.size() + m_inflight;
 }
 
 }
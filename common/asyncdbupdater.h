@@ -2,7 +2,6 @@
 
 #include <string>
 #include <deque>
-#include <list>
 #include <condition_variable>
 #include "dbconnector.h"
 #include "table.h"
@@ -13,6 +12,14 @@
 
 namespace swss {
 
+struct KcoView;
+struct KcoViewMessage;
+
+/*
+ * Writes the updates to the DB from a background thread. The thread takes
+ * the whole queue at once, only writes the last update of every key and
+ * sends the batch in one pipeline, each SET replacing the hash atomically.
+ */
 class AsyncDBUpdater
 {
 public:
@@ -21,10 +28,33 @@ public:
 
     void update(std::shared_ptr<KeyOpFieldsValuesTuple> pkco);
 
+    void update(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &pkcos);
+
+    /* Write the KCOs of a received message straight from its buffer */
+    void update(std::shared_ptr<const KcoViewMessage> message);
+
+    /* Number of updates not written to the DB yet */
     size_t queueSize();
+
+    /*
+     * Backpressure: update() blocks while this many updates are queued,
+     * until the thread takes them. 0, the default, never blocks.
+     */
+    void setMaxQueueSize(size_t maxQueueSize);
+
 private:
+    /* An owned tuple, or a KCO viewed in a received message */
+    struct Update
+    {
+        std::shared_ptr<KeyOpFieldsValuesTuple> kco;
+        std::shared_ptr<const KcoViewMessage> message;
+        const KcoView *view;
+    };
+
     void dbUpdateThread();
 
+    void waitQueueSpace(std::unique_lock<std::mutex> &lock);
+
     volatile bool m_runThread;
 
     std::shared_ptr<std::thread> m_dbUpdateThread;
@@ -33,7 +63,14 @@ private:
 
     std::condition_variable m_dbUpdateDataNotifyCv;
 
-    std::queue<std::shared_ptr<KeyOpFieldsValuesTuple>, std::list<std::shared_ptr<KeyOpFieldsValuesTuple>>> m_dbUpdateDataQueue;
+    std::condition_variable m_queueSpaceCv;
+
+    std::deque<Update> m_dbUpdateDataQueue;
+
+    // updates taken by the thread but not written yet
+    size_t m_inflight;
+
+    size_t m_maxQueueSize;
 
     DBConnector *m_db;
 
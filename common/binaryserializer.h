@@ -6,15 +6,114 @@
 #include "common/table.h"
 
 #include <string>
+#include <memory>
+#include <unordered_map>
 
 using namespace std;
 
 namespace swss {
 
+/* Non owning view of a string inside a serialized buffer */
+struct BinaryStringView
+{
+    const char *data;
+    size_t size;
+
+    std::string str() const
+    {
+        return std::string(data, size);
+    }
+
+    bool operator==(const std::string &other) const
+    {
+        return size == other.size() && memcmp(data, other.data(), size) == 0;
+    }
+};
+
+typedef std::pair<BinaryStringView, BinaryStringView> FieldValueView;
+
+/* Non owning view of a KeyOpFieldsValuesTuple inside a serialized buffer */
+struct KcoView
+{
+    BinaryStringView key;
+    const FieldValueView *fieldValues;
+    size_t fieldValueCount;
+    bool del;
+
+    bool isDel() const
+    {
+        return del;
+    }
+
+    const FieldValueView *begin() const
+    {
+        return fieldValues;
+    }
+
+    const FieldValueView *end() const
+    {
+        return fieldValues + fieldValueCount;
+    }
+
+    /* Copy the viewed data into an owning tuple */
+    KeyOpFieldsValuesTuple toKco() const
+    {
+        KeyOpFieldsValuesTuple kco(key.str(), isDel() ? DEL_COMMAND : SET_COMMAND, {});
+        auto &fvs = kfvFieldsValues(kco);
+        fvs.reserve(fieldValueCount);
+        for (auto &fv : *this)
+        {
+            fvs.emplace_back(fv.first.str(), fv.second.str());
+        }
+        return kco;
+    }
+};
+
+/*
+ * A deserialized message viewing the received buffer, the owner keeps the
+ * buffer alive as long as the message, so handlers can keep the message
+ * and only copy the strings they need to own.
+ * The views point into the message itself, so it can't be copied.
+ */
+struct KcoViewMessage
+{
+    KcoViewMessage() = default;
+    KcoViewMessage(const KcoViewMessage&) = delete;
+    KcoViewMessage& operator=(const KcoViewMessage&) = delete;
+
+    std::shared_ptr<const void> owner;
+    BinaryStringView dbName = { nullptr, 0 };
+    BinaryStringView tableName = { nullptr, 0 };
+    std::vector<KcoView> kcos;
+    std::vector<FieldValueView> fieldValues;
+    // Set by ZmqServer: the sender and the id of its request, to respond to it
+    std::string clientId;
+    uint64_t requestId = 0;
+};
+
 class BinarySerializer {
 public:
+    /* Wire formats, the decoder detects the format of every message */
+    enum class Format
+    {
+        V1,                     // size_t lengths, decimal attribute count, DEL has no attribute
+        V2,                     // varint lengths and counts, explicit operation
+        V2_FIELD_DICTIONARY,    // V2, a repeated field name is sent once per message
+    };
+
+    /*
+     * The size of the serialized message, for V2 it is an upper bound as
+     * the field dictionary may make the message smaller, serializeBuffer()
+     * returns the exact size.
+     */
     static size_t serializedSize(const string &dbName, const string &tableName,
-                                 const vector<KeyOpFieldsValuesTuple> &kcos) {
+                                 const vector<KeyOpFieldsValuesTuple> &kcos,
+                                 Format format = Format::V1) {
+        if (format != Format::V1)
+        {
+            return serializedSizeV2(dbName, tableName, kcos);
+        }
+
         size_t n = 0;
         n += dbName.size() + sizeof(size_t);
         n += tableName.size() + sizeof(size_t);
@@ -38,8 +137,14 @@ public:
         const size_t size,
         const std::string& dbName,
         const std::string& tableName,
-        const std::vector<KeyOpFieldsValuesTuple>& kcos)
+        const std::vector<KeyOpFieldsValuesTuple>& kcos,
+        Format format = Format::V1)
     {
+        if (format != Format::V1)
+        {
+            return serializeBufferV2(buffer, size, dbName, tableName, kcos, format == Format::V2_FIELD_DICTIONARY);
+        }
+
         auto tmpSerializer = BinarySerializer(buffer, size);
 
         // Set the first pair as DB name and table name.
@@ -127,50 +232,506 @@ public:
         std::string& tableName,
         std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos)
     {
-        std::vector<FieldValueTuple> values;
-        deserializeBuffer(buffer, size, values);
-        int fvs_size = -1;
-        KeyOpFieldsValuesTuple kco;
-        auto& key = kfvKey(kco);
-        auto& op = kfvOp(kco);
-        auto& fvs = kfvFieldsValues(kco);
-        for (auto& fv : values)
-        {
-            auto& field = fvField(fv);
-            auto& value = fvValue(fv);
-            // The first pair is the DB name and the table name.
-            if (fvs_size < 0)
+        KcoViewMessage message;
+        deserializeBuffer(buffer, size, message);
+
+        dbName = message.dbName.str();
+        tableName = message.tableName.str();
+        kcos.reserve(kcos.size() + message.kcos.size());
+        for (auto& kco : message.kcos)
+        {
+            kcos.push_back(std::make_shared<KeyOpFieldsValuesTuple>(kco.toKco()));
+        }
+    }
+
+    /* Decode only the DB name and table name of a message */
+    static void deserializeHeader(
+        const char* buffer,
+        const size_t size,
+        BinaryStringView& dbName,
+        BinaryStringView& tableName)
+    {
+        if (isV2(buffer, size))
+        {
+            size_t offset = V2_HEADER_SIZE;
+            dbName = readViewV2(buffer, size, offset);
+            tableName = readViewV2(buffer, size, offset);
+            return;
+        }
+
+        if (size < sizeof(size_t))
+        {
+            SWSS_LOG_THROW("serialized data was truncated, size: %zu", size);
+        }
+
+        size_t offset = sizeof(size_t);
+        dbName = readView(buffer, size, offset);
+        tableName = readView(buffer, size, offset);
+    }
+
+    /* Decode the message without copying, the views point into buffer */
+    static void deserializeBuffer(
+        const char* buffer,
+        const size_t size,
+        KcoViewMessage& message)
+    {
+        message.kcos.clear();
+        message.fieldValues.clear();
+
+        if (isV2(buffer, size))
+        {
+            deserializeBufferV2(buffer, size, message);
+            return;
+        }
+
+        if (size < sizeof(size_t))
+        {
+            SWSS_LOG_THROW("serialized data was truncated, size: %zu", size);
+        }
+
+        WARNINGS_NO_CAST_ALIGN;
+        size_t kvp_count = *(const size_t*)buffer;
+        WARNINGS_RESET;
+
+        if (kvp_count == 0)
+        {
+            return;
+        }
+
+        size_t offset = sizeof(size_t);
+        // The first pair is the DB name and the table name.
+        message.dbName = readView(buffer, size, offset);
+        message.tableName = readView(buffer, size, offset);
+        kvp_count--;
+
+        // Every request starts with the key and the number of attributes,
+        // followed by the attribute pairs. The views are linked to the
+        // request once all of them are read, as fieldValues may reallocate.
+        std::vector<size_t> firstFieldValue;
+        while (kvp_count > 0)
+        {
+            kvp_count--;
+
+            KcoView kco;
+            kco.key = readView(buffer, size, offset);
+            kco.fieldValueCount = parseCount(readView(buffer, size, offset));
+            kco.fieldValues = nullptr;
+            // V1 has no operation, a request without attribute is a DEL request
+            kco.del = kco.fieldValueCount == 0;
+            if (kco.fieldValueCount > kvp_count)
+            {
+                SWSS_LOG_THROW("serialized request was truncated, attribute count: %zu, remaining pairs: %zu",
+                                                                                            kco.fieldValueCount,
+                                                                                            kvp_count);
+            }
+
+            firstFieldValue.push_back(message.fieldValues.size());
+            for (size_t i = 0; i < kco.fieldValueCount; i++)
+            {
+                auto field = readView(buffer, size, offset);
+                auto value = readView(buffer, size, offset);
+                message.fieldValues.emplace_back(field, value);
+            }
+            kvp_count -= kco.fieldValueCount;
+
+            message.kcos.push_back(kco);
+        }
+
+        for (size_t i = 0; i < message.kcos.size(); i++)
+        {
+            message.kcos[i].fieldValues = message.fieldValues.data() + firstFieldValue[i];
+        }
+    }
+
+private:
+    /*
+     * V2 message layout, all lengths and counts are LEB128 varints:
+     *   magic (4 bytes 0xff), version, flags,
+     *   DB name length, DB name, table name length, table name, request count,
+     *   every request: operation byte, key length, key, attribute count, attributes.
+     * An attribute is the field followed by the value length and the value.
+     * Without dictionary a field is its length and bytes. With the dictionary
+     * a field is tagged: (length << 1) followed by the bytes of a new field
+     * name, which takes the next dictionary index, or (index << 1) | 1 for a
+     * field name already sent in the message.
+     * A V1 message starts with its pair count, whose low 32 bits are never all set.
+     */
+    static const size_t V2_HEADER_SIZE = 6;
+    static const uint8_t V2_VERSION = 2;
+    static const uint8_t V2_FLAG_FIELD_DICTIONARY = 0x1;
+    static const uint8_t V2_OP_SET = 0;
+    static const uint8_t V2_OP_DEL = 1;
+
+    static bool isV2(const char* buffer, const size_t size)
+    {
+        return size >= V2_HEADER_SIZE
+            && static_cast<uint8_t>(buffer[0]) == 0xff
+            && static_cast<uint8_t>(buffer[1]) == 0xff
+            && static_cast<uint8_t>(buffer[2]) == 0xff
+            && static_cast<uint8_t>(buffer[3]) == 0xff;
+    }
+
+    static size_t varintSize(uint64_t value)
+    {
+        size_t n = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    static size_t serializedSizeV2(const string &dbName, const string &tableName,
+                                   const vector<KeyOpFieldsValuesTuple> &kcos)
+    {
+        size_t n = V2_HEADER_SIZE;
+        n += varintSize(dbName.size()) + dbName.size();
+        n += varintSize(tableName.size()) + tableName.size();
+        n += varintSize(kcos.size());
+
+        for (const KeyOpFieldsValuesTuple &kco : kcos) {
+            const vector<FieldValueTuple> &fvs = kfvFieldsValues(kco);
+            n += 1 + varintSize(kfvKey(kco).size()) + kfvKey(kco).size();
+            n += varintSize(fvs.size());
+
+            for (const FieldValueTuple &fv : fvs) {
+                // the tag of a new dictionary field takes one more bit
+                n += varintSize(fvField(fv).size() << 1) + fvField(fv).size();
+                n += varintSize(fvValue(fv).size()) + fvValue(fv).size();
+            }
+        }
+
+        return n;
+    }
+
+    static void writeVarint(char* buffer, const size_t size, size_t& offset, uint64_t value)
+    {
+        if (offset + varintSize(value) > size)
+        {
+            SWSS_LOG_THROW("There are not enough buffer for binary serializer to serialize, offset: %zu, buffer size: %zu",
+                                                offset,
+                                                size);
+        }
+
+        while (value >= 0x80)
+        {
+            buffer[offset++] = static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        buffer[offset++] = static_cast<char>(value);
+    }
+
+    static void writeBytes(char* buffer, const size_t size, size_t& offset, const char* data, size_t len)
+    {
+        if (len > size - offset)
+        {
+            SWSS_LOG_THROW("There are not enough buffer for binary serializer to serialize,\n"
+                           "  data length %zu, offset: %zu, buffer size: %zu",
+                                                len,
+                                                offset,
+                                                size);
+        }
+
+        memcpy(buffer + offset, data, len);
+        offset += len;
+    }
+
+    static void writeString(char* buffer, const size_t size, size_t& offset, const std::string& str)
+    {
+        writeVarint(buffer, size, offset, str.size());
+        writeBytes(buffer, size, offset, str.data(), str.size());
+    }
+
+    struct StringPtrHash
+    {
+        size_t operator()(const std::string* str) const
+        {
+            return std::hash<std::string>()(*str);
+        }
+    };
+
+    struct StringPtrEqual
+    {
+        bool operator()(const std::string* a, const std::string* b) const
+        {
+            return *a == *b;
+        }
+    };
+
+    typedef std::unordered_map<const std::string*, size_t, StringPtrHash, StringPtrEqual> FieldIndex;
+
+    // A table has a few distinct field names, a linear scan is faster than
+    // hashing them until the dictionary grows.
+    static const size_t FIELD_LINEAR_SCAN_MAX = 16;
+
+    static size_t findField(const std::vector<const std::string*>& dictionary, const FieldIndex& index, const std::string& field)
+    {
+        if (dictionary.size() <= FIELD_LINEAR_SCAN_MAX)
+        {
+            for (size_t i = 0; i < dictionary.size(); i++)
             {
-                dbName = field;
-                tableName = value;
-                fvs_size = 0;
-                continue;
-            }
-            // This is the beginning of a request.
-            // The first pair is the key and the number of attributes.
-            // If the attribute count is zero, it is a DEL request.
-            if (fvs_size == 0)
+                if (*dictionary[i] == field)
+                {
+                    return i;
+                }
+            }
+            return dictionary.size();
+        }
+
+        auto iter = index.find(&field);
+        return iter == index.end() ? dictionary.size() : iter->second;
+    }
+
+    static void addField(std::vector<const std::string*>& dictionary, FieldIndex& index, const std::string& field)
+    {
+        dictionary.push_back(&field);
+        if (dictionary.size() > FIELD_LINEAR_SCAN_MAX)
+        {
+            if (index.empty())
             {
-                key = field;
-                fvs_size = std::stoi(value);
-                op = (fvs_size == 0) ? DEL_COMMAND : SET_COMMAND;
-                fvs.clear();
+                for (size_t i = 0; i < dictionary.size(); i++)
+                {
+                    index.emplace(dictionary[i], i);
+                }
             }
-            // This is an attribut pair.
             else
             {
-                fvs.push_back(fv);
-                --fvs_size;
+                index.emplace(&field, dictionary.size() - 1);
             }
-            // We got the last attribut pair. This is the end of a request.
-            if (fvs_size == 0)
+        }
+    }
+
+    static size_t serializeBufferV2(
+        char* buffer,
+        const size_t size,
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<KeyOpFieldsValuesTuple>& kcos,
+        bool fieldDictionary)
+    {
+        if (size < V2_HEADER_SIZE)
+        {
+            SWSS_LOG_THROW("There are not enough buffer for binary serializer to serialize, buffer size: %zu", size);
+        }
+
+        memset(buffer, 0xff, 4);
+        buffer[4] = static_cast<char>(V2_VERSION);
+        buffer[5] = static_cast<char>(fieldDictionary ? V2_FLAG_FIELD_DICTIONARY : 0);
+        size_t offset = V2_HEADER_SIZE;
+        writeString(buffer, size, offset, dbName);
+        writeString(buffer, size, offset, tableName);
+        writeVarint(buffer, size, offset, kcos.size());
+
+        // The field names point into kcos, which outlive the dictionary
+        std::vector<const std::string*> dictionary;
+        FieldIndex dictionaryIndex;
+        for (auto& kco : kcos)
+        {
+            auto& fvs = kfvFieldsValues(kco);
+            uint8_t op = kfvOp(kco) == DEL_COMMAND ? V2_OP_DEL : V2_OP_SET;
+            writeBytes(buffer, size, offset, reinterpret_cast<const char*>(&op), 1);
+            writeString(buffer, size, offset, kfvKey(kco));
+            writeVarint(buffer, size, offset, fvs.size());
+            for (auto& fv : fvs)
             {
-                kcos.push_back(std::make_shared<KeyOpFieldsValuesTuple>(kco));
+                auto& field = fvField(fv);
+                if (fieldDictionary)
+                {
+                    size_t index = findField(dictionary, dictionaryIndex, field);
+                    if (index < dictionary.size())
+                    {
+                        writeVarint(buffer, size, offset, (static_cast<uint64_t>(index) << 1) | 1);
+                    }
+                    else
+                    {
+                        addField(dictionary, dictionaryIndex, field);
+                        writeVarint(buffer, size, offset, static_cast<uint64_t>(field.size()) << 1);
+                        writeBytes(buffer, size, offset, field.data(), field.size());
+                    }
+                }
+                else
+                {
+                    writeString(buffer, size, offset, field);
+                }
+
+                writeString(buffer, size, offset, fvValue(fv));
             }
         }
+
+        return offset;
+    }
+
+    static uint64_t readVarint(const char* buffer, const size_t size, size_t& offset)
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (offset >= size)
+            {
+                SWSS_LOG_THROW("serialized data length was truncated, offset: %zu, buffer size: %zu",
+                                                                                            offset,
+                                                                                            size);
+            }
+
+            auto byte = static_cast<uint8_t>(buffer[offset++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+
+        SWSS_LOG_THROW("serialized varint is invalid, offset: %zu", offset);
+    }
+
+    static BinaryStringView readBytesV2(const char* buffer, const size_t size, size_t& offset, uint64_t len)
+    {
+        if (len > size - offset)
+        {
+            SWSS_LOG_THROW("serialized data was truncated, data length: %zu, increase buffer size: %zu",
+                                                                                            static_cast<size_t>(len),
+                                                                                            size);
+        }
+
+        BinaryStringView view = { buffer + offset, static_cast<size_t>(len) };
+        offset += view.size;
+        return view;
+    }
+
+    static BinaryStringView readViewV2(const char* buffer, const size_t size, size_t& offset)
+    {
+        auto len = readVarint(buffer, size, offset);
+        return readBytesV2(buffer, size, offset, len);
+    }
+
+    static void deserializeBufferV2(const char* buffer, const size_t size, KcoViewMessage& message)
+    {
+        if (static_cast<uint8_t>(buffer[4]) != V2_VERSION)
+        {
+            SWSS_LOG_THROW("serialized data version %u is not supported", static_cast<uint8_t>(buffer[4]));
+        }
+
+        bool fieldDictionary = buffer[5] & V2_FLAG_FIELD_DICTIONARY;
+        size_t offset = V2_HEADER_SIZE;
+        message.dbName = readViewV2(buffer, size, offset);
+        message.tableName = readViewV2(buffer, size, offset);
+
+        // Every request takes 3 bytes at least, don't trust a count beyond the buffer
+        auto count = readVarint(buffer, size, offset);
+        if (count > (size - offset) / 3)
+        {
+            SWSS_LOG_THROW("serialized request count was truncated, count: %zu, buffer size: %zu",
+                                                                                            static_cast<size_t>(count),
+                                                                                            size);
+        }
+        message.kcos.reserve(static_cast<size_t>(count));
+
+        // The views are linked to the requests once all of them are read,
+        // as fieldValues may reallocate.
+        std::vector<BinaryStringView> dictionary;
+        std::vector<size_t> firstFieldValue;
+        firstFieldValue.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; i++)
+        {
+            KcoView kco;
+            auto op = readBytesV2(buffer, size, offset, 1);
+            kco.del = static_cast<uint8_t>(op.data[0]) == V2_OP_DEL;
+            kco.key = readViewV2(buffer, size, offset);
+            kco.fieldValues = nullptr;
+
+            // Every attribute takes 2 bytes at least
+            auto fieldValueCount = readVarint(buffer, size, offset);
+            if (fieldValueCount > (size - offset) / 2)
+            {
+                SWSS_LOG_THROW("serialized request was truncated, attribute count: %zu, buffer size: %zu",
+                                                                                            static_cast<size_t>(fieldValueCount),
+                                                                                            size);
+            }
+            kco.fieldValueCount = static_cast<size_t>(fieldValueCount);
+
+            firstFieldValue.push_back(message.fieldValues.size());
+            for (size_t j = 0; j < kco.fieldValueCount; j++)
+            {
+                BinaryStringView field;
+                if (fieldDictionary)
+                {
+                    auto tag = readVarint(buffer, size, offset);
+                    if (tag & 1)
+                    {
+                        auto index = tag >> 1;
+                        if (index >= dictionary.size())
+                        {
+                            SWSS_LOG_THROW("serialized field index %zu is not in the dictionary of %zu fields",
+                                                                                            static_cast<size_t>(index),
+                                                                                            dictionary.size());
+                        }
+                        field = dictionary[static_cast<size_t>(index)];
+                    }
+                    else
+                    {
+                        field = readBytesV2(buffer, size, offset, tag >> 1);
+                        dictionary.push_back(field);
+                    }
+                }
+                else
+                {
+                    field = readViewV2(buffer, size, offset);
+                }
+
+                auto value = readViewV2(buffer, size, offset);
+                message.fieldValues.emplace_back(field, value);
+            }
+
+            message.kcos.push_back(kco);
+        }
+
+        for (size_t i = 0; i < message.kcos.size(); i++)
+        {
+            message.kcos[i].fieldValues = message.fieldValues.data() + firstFieldValue[i];
+        }
+    }
+
+    static BinaryStringView readView(const char* buffer, const size_t size, size_t& offset)
+    {
+        if (offset + sizeof(size_t) > size)
+        {
+            SWSS_LOG_THROW("serialized data length was truncated, offset: %zu, buffer size: %zu",
+                                                                                            offset,
+                                                                                            size);
+        }
+
+        WARNINGS_NO_CAST_ALIGN;
+        size_t len = *(const size_t*)(buffer + offset);
+        WARNINGS_RESET;
+
+        offset += sizeof(size_t);
+        if (len > size - offset)
+        {
+            SWSS_LOG_THROW("serialized data was truncated, data length: %zu, increase buffer size: %zu",
+                                                                                            len,
+                                                                                            size);
+        }
+
+        BinaryStringView view = { buffer + offset, len };
+        offset += len;
+        return view;
+    }
+
+    static size_t parseCount(const BinaryStringView& view)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < view.size; i++)
+        {
+            if (view.data[i] < '0' || view.data[i] > '9')
+            {
+                SWSS_LOG_THROW("serialized attribute count is invalid: %s", view.str().c_str());
+            }
+            count = count * 10 + static_cast<size_t>(view.data[i] - '0');
+        }
+        return count;
     }
 
-private:
     char* m_buffer;
     const size_t m_buffer_size;
     char* m_current_position;
@@ -0,0 +1,38 @@
+-- Same as consumer_state_table_pops.lua, but the popped batch is returned as one
+-- bulk string instead of a nested table, so that the client gets a single reply.
+-- Every key is encoded as:
+--   <keylen><key><count> followed by count pairs of <fieldlen><field><valuelen><value>
+-- where all lengths and counts are 32-bit unsigned big-endian integers.
+-- A key with zero field/value pairs has been deleted.
+redis.replicate_commands()
+local ret = {}
+local tablename = KEYS[2]
+local stateprefix = ARGV[2]
+local keys = redis.call('SPOP', KEYS[1], ARGV[1])
+local n = table.getn(keys)
+-- unpack() is bounded by the lua C stack, split huge hashes into several HSETs
+local maxunpack = 4000
+for i = 1, n do
+   local key = keys[i]
+   -- Check if there was request to delete the key, clear it in table first
+   local num = redis.call('SREM', KEYS[3], key)
+   if num == 1 then
+      redis.call('DEL', tablename..key)
+   end
+   -- Push the new set of field/value for this key in table
+   local fieldvalues = redis.call('HGETALL', stateprefix..tablename..key)
+   local nfv = #fieldvalues
+   table.insert(ret, struct.pack('>I4', #key))
+   table.insert(ret, key)
+   table.insert(ret, struct.pack('>I4', nfv / 2))
+   for j = 1, nfv do
+      table.insert(ret, struct.pack('>I4', #fieldvalues[j]))
+      table.insert(ret, fieldvalues[j])
+   end
+   for j = 1, nfv, maxunpack do
+      redis.call('HSET', tablename..key, unpack(fieldvalues, j, math.min(j + maxunpack - 1, nfv)))
+   end
+   -- Clean up the key in temporary state table
+   redis.call('DEL', stateprefix..tablename..key)
+end
+return table.concat(ret)
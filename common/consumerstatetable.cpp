@@ -1,6 +1,7 @@
 #include <string>
 #include <deque>
 #include <limits>
+#include <chrono>
 #include <hiredis/hiredis.h>
 #include "dbconnector.h"
 #include "table.h"
@@ -14,6 +15,7 @@ namespace swss {
 ConsumerStateTable::ConsumerStateTable(DBConnector *db, const std::string &tableName, int popBatchSize, int pri)
     : ConsumerTableBase(db, tableName, popBatchSize, pri)
     , TableName_KeySet(tableName)
+    , m_packedPops(false)
 {
     std::string luaScript = loadLuaScript("consumer_state_table_pops.lua");
     m_shaPop = loadRedisScript(db, luaScript);
@@ -33,23 +35,91 @@ ConsumerStateTable::ConsumerStateTable(DBConnector *db, const std::string &table
     setQueueLength(r.getReply<long long int>());
 }
 
-void ConsumerStateTable::pops(std::deque<KeyOpFieldsValuesTuple> &vkco, const std::string& /*prefix*/)
+void ConsumerStateTable::setPackedPops(bool packed)
 {
+    if (packed && m_shaPackedPop.empty())
+    {
+        std::string luaScript = loadLuaScript("consumer_state_table_pops_packed.lua");
+        m_shaPackedPop = loadRedisScript(m_db, luaScript);
+    }
+
+    m_packedPops = packed;
+}
 
+redisReply *ConsumerStateTable::runPopScript(const std::string &sha, long long int &backlog)
+{
     RedisCommand command;
     command.format(
         "EVALSHA %s 3 %s %s%s %s %d %s",
-        m_shaPop.c_str(),
+        sha.c_str(),
         getKeySetName().c_str(),
         getTableName().c_str(),
         getTableNameSeparator().c_str(),
         getDelKeySetName().c_str(),
-        POP_BATCH_SIZE,
+        getPopBatchSize(),
         getStateHashPrefix().c_str());
 
-    RedisReply r(m_db, command);
-    auto ctx0 = r.getContext();
+    if (!isAdaptivePopBatchSize())
+    {
+        RedisReply r(m_db, command);
+        return r.release();
+    }
+
+    // Pipeline SCARD behind the pop, so the backlog costs no extra round trip
+    RedisCommand scard;
+    scard.format("SCARD %s", getKeySetName().c_str());
+
+    redisContext *ctx = m_db->getContext();
+    if (command.appendTo(ctx) != REDIS_OK || scard.appendTo(ctx) != REDIS_OK)
+    {
+        throw std::bad_alloc();
+    }
+
+    // Always read both replies to keep the connection in sync
+    redisReply *reply = nullptr;
+    redisReply *scardReply = nullptr;
+    if (redisGetReply(ctx, (void**)&reply) != REDIS_OK
+        || redisGetReply(ctx, (void**)&scardReply) != REDIS_OK)
+    {
+        freeReplyObject(reply);
+        throw RedisError("Failed to redisGetReply with " + command.toPrintableString(), ctx);
+    }
+
+    RedisReply r(reply);
+    RedisReply b(scardReply);
+    b.checkReplyType(REDIS_REPLY_INTEGER);
+    backlog = b.getReply<long long int>();
+    return r.release();
+}
+
+void ConsumerStateTable::pops(std::deque<KeyOpFieldsValuesTuple> &vkco, const std::string& /*prefix*/)
+{
+    auto start = std::chrono::steady_clock::now();
+    long long int backlog = -1;
+
     vkco.clear();
+    if (m_packedPops)
+    {
+        popsPacked(vkco, backlog);
+    }
+    else
+    {
+        popsNested(vkco, backlog);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    updatePopBatchSize(backlog, static_cast<uint64_t>(elapsed.count()));
+}
+
+void ConsumerStateTable::popsNested(std::deque<KeyOpFieldsValuesTuple> &vkco, long long int &backlog)
+{
+    RedisReply r(runPopScript(m_shaPop, backlog));
+    if (r.getContext()->type != REDIS_REPLY_NIL)
+    {
+        r.checkReplyType(REDIS_REPLY_ARRAY);
+    }
+
+    auto ctx0 = r.getContext();
 
     // if the set is empty, return an empty kco object
     if (ctx0->type == REDIS_REPLY_NIL)
@@ -93,4 +163,62 @@ void ConsumerStateTable::pops(std::deque<KeyOpFieldsValuesTuple> &vkco, const st
     }
 }
 
+static uint32_t readPackedUint32(const char *&pos, const char *end)
+{
+    if (end - pos < 4)
+    {
+        SWSS_LOG_THROW("Packed pops reply was truncated");
+    }
+
+    auto p = reinterpret_cast<const unsigned char *>(pos);
+    pos += 4;
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static void readPackedString(const char *&pos, const char *end, std::string &str)
+{
+    uint32_t len = readPackedUint32(pos, end);
+    if (static_cast<size_t>(end - pos) < len)
+    {
+        SWSS_LOG_THROW("Packed pops reply was truncated, string length: %u", len);
+    }
+
+    str.assign(pos, len);
+    pos += len;
+}
+
+void ConsumerStateTable::popsPacked(std::deque<KeyOpFieldsValuesTuple> &vkco, long long int &backlog)
+{
+    RedisReply r(runPopScript(m_shaPackedPop, backlog));
+    r.checkReplyType(REDIS_REPLY_STRING);
+    auto ctx = r.getContext();
+
+    // See consumer_state_table_pops_packed.lua for the encoding
+    const char *pos = ctx->str;
+    const char *end = ctx->str + ctx->len;
+    while (pos < end)
+    {
+        vkco.emplace_back();
+        auto& kco = vkco.back();
+        readPackedString(pos, end, kfvKey(kco));
+
+        auto& values = kfvFieldsValues(kco);
+        uint32_t n = readPackedUint32(pos, end);
+        if (n > static_cast<size_t>(end - pos) / 8)
+        {
+            SWSS_LOG_THROW("Packed pops reply was truncated, field count: %u", n);
+        }
+
+        values.resize(n);
+        for (auto& fv : values)
+        {
+            readPackedString(pos, end, fvField(fv));
+            readPackedString(pos, end, fvValue(fv));
+        }
+
+        // if there is no field-value pair, the key is already deleted
+        kfvOp(kco) = values.empty() ? DEL_COMMAND : SET_COMMAND;
+    }
+}
+
 }
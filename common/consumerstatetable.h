@@ -15,8 +15,23 @@ public:
     /* Get multiple pop elements */
     void pops(std::deque<KeyOpFieldsValuesTuple> &vkco, const std::string &prefix = EMPTY_PREFIX);
 
+    /*
+     * Pop the whole batch as one packed bulk string reply instead of one
+     * reply object per key, field and value. Disabled by default.
+     */
+    void setPackedPops(bool packed);
+
+protected:
+    bool supportsAdaptivePopBatchSize() const override { return true; }
+
 private:
     std::string m_shaPop;
+    std::string m_shaPackedPop;
+    bool m_packedPops;
+
+    redisReply *runPopScript(const std::string &sha, long long int &backlog);
+    void popsNested(std::deque<KeyOpFieldsValuesTuple> &vkco, long long int &backlog);
+    void popsPacked(std::deque<KeyOpFieldsValuesTuple> &vkco, long long int &backlog);
 };
 
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "consumertablebase.h"
 
 namespace swss {
@@ -5,7 +6,14 @@ namespace swss {
 ConsumerTableBase::ConsumerTableBase(DBConnector *db, const std::string &tableName, int popBatchSize, int pri):
         TableConsumable(tableName, SonicDBConfig::getSeparator(db), pri),
         RedisTransactioner(db),
-        POP_BATCH_SIZE(popBatchSize)
+        POP_BATCH_SIZE(popBatchSize),
+        m_popBatchSize(popBatchSize),
+        m_adaptivePopBatchSize(false),
+        m_minPopBatchSize(popBatchSize),
+        m_maxPopBatchSize(popBatchSize),
+        m_popLatencyBudget(0),
+        m_popBacklog(-1),
+        m_lastPopLatency(0)
 {
 }
 
@@ -14,6 +22,58 @@ const DBConnector* ConsumerTableBase::getDbConnector() const
     return m_db;
 }
 
+void ConsumerTableBase::setAdaptivePopBatchSize(int minBatchSize, int maxBatchSize, uint64_t latencyBudgetUs)
+{
+    SWSS_LOG_ENTER();
+
+    if (!supportsAdaptivePopBatchSize())
+    {
+        SWSS_LOG_THROW("Table %s doesn't support an adaptive pop batch size", getTableName().c_str());
+    }
+
+    if (minBatchSize <= 0 || minBatchSize > maxBatchSize)
+    {
+        SWSS_LOG_THROW("Invalid adaptive pop batch size range [%d, %d]", minBatchSize, maxBatchSize);
+    }
+
+    m_adaptivePopBatchSize = true;
+    m_minPopBatchSize = minBatchSize;
+    m_maxPopBatchSize = maxBatchSize;
+    m_popLatencyBudget = latencyBudgetUs;
+    m_popBatchSize = std::min(std::max(m_popBatchSize, minBatchSize), maxBatchSize);
+}
+
+void ConsumerTableBase::disableAdaptivePopBatchSize()
+{
+    SWSS_LOG_ENTER();
+
+    m_adaptivePopBatchSize = false;
+    m_popBatchSize = POP_BATCH_SIZE;
+    m_popBacklog = -1;
+}
+
+void ConsumerTableBase::updatePopBatchSize(long long int backlog, uint64_t latencyUs)
+{
+    m_popBacklog = backlog;
+    m_lastPopLatency = latencyUs;
+
+    if (!m_adaptivePopBatchSize)
+    {
+        return;
+    }
+
+    if (latencyUs > m_popLatencyBudget)
+    {
+        // Give other selectables a chance sooner
+        m_popBatchSize = std::max(m_popBatchSize / 2, m_minPopBatchSize);
+    }
+    else if (backlog > m_popBatchSize)
+    {
+        // Drain the backlog with fewer round trips
+        m_popBatchSize = static_cast<int>(std::min(static_cast<long long int>(m_popBatchSize) * 2, static_cast<long long int>(m_maxPopBatchSize)));
+    }
+}
+
 void ConsumerTableBase::pop(KeyOpFieldsValuesTuple &kco, const std::string &prefix)
 {
     pop(kfvKey(kco), kfvOp(kco), kfvFieldsValues(kco), prefix);
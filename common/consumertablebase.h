@@ -21,9 +21,46 @@ public:
     void pop(std::string &key, std::string &op, std::vector<FieldValueTuple> &fvs, const std::string &prefix = EMPTY_PREFIX);
 
     bool empty() const { return m_buffer.empty(); };
+
+    /*
+     * Let the pop batch size adapt between minBatchSize and maxBatchSize.
+     * The batch size doubles while the backlog left after a pop is larger
+     * than the batch, and halves when a pop takes longer than latencyBudgetUs
+     * microseconds.
+     * Only tables that report their backlog (ConsumerStateTable) adapt,
+     * throw for the others.
+     */
+    void setAdaptivePopBatchSize(int minBatchSize, int maxBatchSize, uint64_t latencyBudgetUs);
+    void disableAdaptivePopBatchSize();
+    bool isAdaptivePopBatchSize() const { return m_adaptivePopBatchSize; }
+
+    /* Batch size used by the next pop */
+    int getPopBatchSize() const { return m_popBatchSize; }
+
+    /* Backlog left after the last pop, -1 if unknown */
+    long long int getPopBacklog() const { return m_popBacklog; }
+
+    /* Time spent by the last pop in microseconds */
+    uint64_t getLastPopLatency() const { return m_lastPopLatency; }
+
 protected:
 
     std::deque<KeyOpFieldsValuesTuple> m_buffer;
+
+    /* true if the pops report their backlog to updatePopBatchSize() */
+    virtual bool supportsAdaptivePopBatchSize() const { return false; }
+
+    /* Record the outcome of a pop and adapt the batch size if enabled */
+    void updatePopBatchSize(long long int backlog, uint64_t latencyUs);
+
+private:
+    int m_popBatchSize;
+    bool m_adaptivePopBatchSize;
+    int m_minPopBatchSize;
+    int m_maxPopBatchSize;
+    uint64_t m_popLatencyBudget;
+    long long int m_popBacklog;
+    uint64_t m_lastPopLatency;
 };
 
 }
@@ -50,4 +50,36 @@ bool DecoratorTable::hget(const string &key, const string &field,  string &value
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+void DecoratorTable::get(const vector<string> &keys, vector<pair<bool, vector<pair<string, string>>>> &out)
+{
+    Table::get(keys, out);
+    auto table = getTableName();
+
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        m_defaultValueProvider->appendDefaultValues(table, keys[i], out[i].second);
+    }
+}
+
+void DecoratorTable::hget(const vector<string> &keys, const string &field, vector<pair<bool, string>> &out)
+{
+    Table::hget(keys, field, out);
+    auto table = getTableName();
+
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        if (out[i].first)
+        {
+            continue;
+        }
+
+        auto default_value = m_defaultValueProvider->getDefaultValue(table, keys[i], field);
+        if (default_value != nullptr)
+        {
+            out[i].first = true;
+            out[i].second = *default_value;
+        }
+    }
+}
@@ -26,6 +26,15 @@ public:
     /* Get an entry field-value from the table */
     bool hget(const std::string &key, const std::string &field,  std::string &value) override;
 
+    /* Get several entries in one round trip, with default values appended */
+    void get(const std::vector<std::string> &keys,
+             std::vector<std::pair<bool, std::vector<std::pair<std::string, std::string>>>> &out) override;
+
+    /* Get the same field of several entries in one round trip, falling back to default values */
+    void hget(const std::vector<std::string> &keys,
+              const std::string &field,
+              std::vector<std::pair<bool, std::string>> &out) override;
+
 private:
     std::shared_ptr<DefaultValueProvider> m_defaultValueProvider;
 };
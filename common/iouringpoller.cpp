@@ -0,0 +1,257 @@
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <system_error>
+#include <algorithm>
+#include "logger.h"
+#include "iouringpoller.h"
+
+using namespace std;
+
+namespace swss {
+
+/* user_data of the requests whose completion is ignored */
+static const uint64_t IGNORED_USER_DATA = UINT64_MAX;
+
+static uint64_t pollUserData(int fd, uint32_t generation)
+{
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+static int ioUringSetup(unsigned entries, struct io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void *arg, size_t argSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+IoUringPoller::IoUringPoller(unsigned entries)
+    : m_sqRing(MAP_FAILED)
+    , m_cqRing(MAP_FAILED)
+    , m_sqes(static_cast<io_uring_sqe *>(MAP_FAILED))
+    , m_nextGeneration(0)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = ioUringSetup(entries, &params);
+    if (m_ringFd < 0)
+    {
+        throw system_error(errno, generic_category(), "io_uring_setup failed");
+    }
+
+    // The timeout of the wait needs IORING_ENTER_EXT_ARG (Linux 5.11)
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        close(m_ringFd);
+        throw system_error(make_error_code(errc::not_supported), "io_uring lacks the features of the poller");
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+    {
+        m_sqRingSize = m_cqRingSize = max(m_sqRingSize, m_cqRingSize);
+    }
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRing != MAP_FAILED)
+    {
+        m_cqRing = singleMmap ? m_sqRing : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+        m_sqes = static_cast<io_uring_sqe *>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES));
+    }
+    if (m_sqRing == MAP_FAILED || m_cqRing == MAP_FAILED || m_sqes == MAP_FAILED)
+    {
+        int err = errno;
+        release();
+        throw system_error(err, generic_category(), "failed to map io_uring");
+    }
+
+    auto sq = static_cast<char *>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto cq = static_cast<char *>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    release();
+}
+
+void IoUringPoller::release()
+{
+    if (m_sqes != MAP_FAILED)
+    {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+    {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing != MAP_FAILED)
+    {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+
+    // closing the ring cancels the pending poll requests
+    close(m_ringFd);
+}
+
+unsigned IoUringPoller::pendingSqes() const
+{
+    return *m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+}
+
+io_uring_sqe *IoUringPoller::getSqe()
+{
+    if (pendingSqes() >= m_sqEntries)
+    {
+        // The queue is full, submit it without waiting
+        if (ioUringEnter(m_ringFd, pendingSqes(), 0, 0, nullptr, 0) < 0)
+        {
+            throw system_error(errno, generic_category(), "io_uring_enter failed");
+        }
+    }
+
+    unsigned tail = *m_sqTail;
+    unsigned index = tail & m_sqMask;
+    auto sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+
+    // The kernel reads the entry at the next io_uring_enter
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+void IoUringPoller::queuePoll(int fd, uint32_t generation)
+{
+    // One shot poll, checks the readiness when it is submitted
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = pollUserData(fd, generation);
+}
+
+void IoUringPoller::add(int fd)
+{
+    auto generation = m_nextGeneration++;
+    m_generations[fd] = generation;
+    queuePoll(fd, generation);
+}
+
+void IoUringPoller::remove(int fd)
+{
+    auto it = m_generations.find(fd);
+    if (it == m_generations.end())
+    {
+        return;
+    }
+
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = pollUserData(fd, it->second);
+    sqe->user_data = IGNORED_USER_DATA;
+    m_generations.erase(it);
+}
+
+void IoUringPoller::reap(std::vector<int> &fds)
+{
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        auto cqe = &m_cqes[head & m_cqMask];
+        if (cqe->user_data == IGNORED_USER_DATA)
+        {
+            continue;
+        }
+
+        int fd = static_cast<int>(static_cast<uint32_t>(cqe->user_data));
+        auto generation = static_cast<uint32_t>(cqe->user_data >> 32);
+        auto it = m_generations.find(fd);
+        if (it == m_generations.end() || it->second != generation)
+        {
+            // completion of a removed fd
+            continue;
+        }
+
+        if (cqe->res < 0)
+        {
+            SWSS_LOG_WARN("io_uring poll of fd %d failed, errno: %d", fd, -cqe->res);
+            m_generations.erase(it);
+            continue;
+        }
+
+        fds.push_back(fd);
+
+        // Re-armed by the next wait, after readData() of the fd
+        m_rearm.emplace_back(fd, generation);
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+}
+
+int IoUringPoller::wait(std::vector<int> &fds, int timeout)
+{
+    for (auto &poll : m_rearm)
+    {
+        auto it = m_generations.find(poll.first);
+        if (it != m_generations.end() && it->second == poll.second)
+        {
+            queuePoll(poll.first, poll.second);
+        }
+    }
+    m_rearm.clear();
+
+    fds.clear();
+    reap(fds);
+
+    int rc = 0;
+    if (fds.empty() && timeout != 0)
+    {
+        // Submit the queued requests and wait in one system call, the
+        // polls of readable fds complete at the submission
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        if (timeout > 0)
+        {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+        rc = ioUringEnter(m_ringFd, pendingSqes(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+    else if (pendingSqes() > 0)
+    {
+        rc = ioUringEnter(m_ringFd, pendingSqes(), 0, 0, nullptr, 0);
+    }
+
+    if (rc < 0 && errno != ETIME)
+    {
+        return -1;
+    }
+
+    reap(fds);
+    return static_cast<int>(fds.size());
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace swss {
+
+/*
+ * Readiness of a set of fds through io_uring poll requests, the io_uring
+ * backend of Select. Adding and removing fds only queue requests, they
+ * are submitted with the next wait() in the same system call.
+ * Every poll request is re-armed by the wait() after the one it completed
+ * in, so an fd still readable after readData() is reported again, like the
+ * level triggered epoll of Select.
+ */
+class IoUringPoller
+{
+public:
+    /* Throw system_error if the kernel doesn't support io_uring */
+    IoUringPoller(unsigned entries = 256);
+    ~IoUringPoller();
+
+    IoUringPoller(const IoUringPoller&) = delete;
+    IoUringPoller& operator=(const IoUringPoller&) = delete;
+
+    void add(int fd);
+
+    void remove(int fd);
+
+    /*
+     * Wait up to timeout ms, -1 for ever, for readable fds and store them
+     * in fds. Return the number of fds, -1 with errno set on error.
+     */
+    int wait(std::vector<int> &fds, int timeout);
+
+private:
+    io_uring_sqe *getSqe();
+    void queuePoll(int fd, uint32_t generation);
+    void reap(std::vector<int> &fds);
+    unsigned pendingSqes() const;
+    void release();
+
+    int m_ringFd;
+
+    void *m_sqRing;
+    size_t m_sqRingSize;
+    void *m_cqRing;
+    size_t m_cqRingSize;
+    io_uring_sqe *m_sqes;
+    size_t m_sqesSize;
+
+    unsigned *m_sqHead;
+    unsigned *m_sqTail;
+    unsigned m_sqMask;
+    unsigned m_sqEntries;
+    unsigned *m_sqArray;
+
+    unsigned *m_cqHead;
+    unsigned *m_cqTail;
+    unsigned m_cqMask;
+    io_uring_cqe *m_cqes;
+
+    // Generation of the poll request of each fd, to drop the completions
+    // of a removed fd whose number is reused
+    std::unordered_map<int, uint32_t> m_generations;
+    uint32_t m_nextGeneration;
+
+    // fd and generation of the polls completed by the last wait
+    std::vector<std::pair<int, uint32_t>> m_rearm;
+};
+
+}
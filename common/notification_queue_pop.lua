@@ -0,0 +1,7 @@
+-- KEYS[1] - notification queue
+-- ARGV[1] - max number of notifications to pop
+-- Return the number of notifications left in the queue, followed by the popped notifications
+local ret = redis.call('LRANGE', KEYS[1], 0, tonumber(ARGV[1]) - 1)
+redis.call('LTRIM', KEYS[1], #ret, -1)
+table.insert(ret, 1, redis.call('LLEN', KEYS[1]))
+return ret
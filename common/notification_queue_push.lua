@@ -0,0 +1,16 @@
+-- KEYS[1] - notification queue, also the wakeup channel
+-- KEYS[2] - counter of the dropped notifications
+-- ARGV[1] - max queue length
+-- ARGV[2] - notification
+-- Return the queue length, 0 when the queue is full and the notification is dropped
+local len = redis.call('LLEN', KEYS[1])
+if len >= tonumber(ARGV[1]) then
+    redis.call('INCR', KEYS[2])
+    return 0
+end
+len = redis.call('RPUSH', KEYS[1], ARGV[2])
+-- The consumer drains the queue on wakeup, it only needs one when the queue was empty
+if len == 1 then
+    redis.call('PUBLISH', KEYS[1], 'G')
+end
+return len
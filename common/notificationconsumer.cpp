@@ -3,20 +3,35 @@
 #include <iostream>
 #include <deque>
 #include "redisapi.h"
+#include "notificationqueue.h"
 
 #define NOTIFICATION_SUBSCRIBE_TIMEOUT (1000)
 #define REDIS_PUBLISH_MESSAGE_INDEX (2)
 #define REDIS_PUBLISH_MESSAGE_ELEMNTS (3)
 
 swss::NotificationConsumer::NotificationConsumer(swss::DBConnector *db, const std::string &channel, int pri, size_t popBatchSize):
+    NotificationConsumer(db, channel, pri, popBatchSize, false)
+{
+}
+
+swss::NotificationConsumer::NotificationConsumer(swss::DBConnector *db, const std::string &channel, int pri, size_t popBatchSize, bool queued):
     Selectable(pri),
     POP_BATCH_SIZE(popBatchSize),
     m_db(db),
     m_subscribe(NULL),
-    m_channel(channel)
+    m_channel(channel),
+    m_queued(queued),
+    m_queueRemaining(0)
 {
     SWSS_LOG_ENTER();
 
+    if (m_queued)
+    {
+        // The producer publishes on the queue when it gets the first notification
+        m_queueName = NotificationQueue::getQueueName(channel);
+        m_shaQueuePop = loadRedisScript(m_db, loadLuaScript("notification_queue_pop.lua"));
+    }
+
     while (true)
     {
         try
@@ -31,6 +46,22 @@ swss::NotificationConsumer::NotificationConsumer(swss::DBConnector *db, const st
             SWSS_LOG_ERROR("failed to subscribe on %s", m_channel.c_str());
         }
     }
+
+    if (m_queued)
+    {
+        // A pop removes the notifications from the queue, a second consumer
+        // would silently take a share of them. Checked once subscribed, so
+        // of two consumers coming up together none is left unnoticed.
+        RedisCommand numsub;
+        numsub.format("PUBSUB NUMSUB %s", m_queueName.c_str());
+        RedisReply r(m_db, numsub, REDIS_REPLY_ARRAY);
+        auto reply = r.getContext();
+        if (reply->elements == 2 && reply->element[1]->type == REDIS_REPLY_INTEGER && reply->element[1]->integer > 1)
+        {
+            delete m_subscribe;
+            SWSS_LOG_THROW("queued channel %s already has a consumer", m_channel.c_str());
+        }
+    }
 }
 
 swss::NotificationConsumer::~NotificationConsumer()
@@ -53,11 +84,11 @@ void swss::NotificationConsumer::subscribe()
                                       m_db->getContext()->unix_sock.path,
                                       NOTIFICATION_SUBSCRIBE_TIMEOUT);
 
-    std::string s = "SUBSCRIBE " + m_channel;
+    std::string s = "SUBSCRIBE " + (m_queued ? m_queueName : m_channel);
 
     RedisReply r(m_subscribe, s, REDIS_REPLY_ARRAY);
 
-    SWSS_LOG_INFO("subscribed to %s", m_channel.c_str());
+    SWSS_LOG_INFO("subscribed to %s", m_queued ? m_queueName.c_str() : m_channel.c_str());
 }
 
 int swss::NotificationConsumer::getFd()
@@ -100,17 +131,81 @@ uint64_t swss::NotificationConsumer::readData()
     {
         throw std::runtime_error("Unable to read redis reply");
     }
+
+    // The messages of a queued channel are wakeups, the queue is popped
+    // only while the consumer keeps up, the rest waits in redis.
+    if (m_queued && m_queue.size() < POP_BATCH_SIZE)
+    {
+        popQueue(POP_BATCH_SIZE - m_queue.size());
+    }
     return 0;
 }
 
 bool swss::NotificationConsumer::hasData()
 {
-    return m_queue.size() > 0;
+    return m_queue.size() > 0 || m_queueRemaining > 0;
 }
 
 bool swss::NotificationConsumer::hasCachedData()
 {
-    return m_queue.size() > 1;
+    return m_queue.size() > 1 || m_queueRemaining > 0;
+}
+
+bool swss::NotificationConsumer::initializedWithData()
+{
+    if (!m_queued)
+    {
+        return false;
+    }
+
+    // Notifications queued before the consumer came up don't wake it up
+    RedisCommand llen;
+    llen.format("LLEN %s", m_queueName.c_str());
+    RedisReply r(m_db, llen, REDIS_REPLY_INTEGER);
+    m_queueRemaining = r.getReply<long long int>();
+
+    return m_queueRemaining > 0;
+}
+
+void swss::NotificationConsumer::popQueue(size_t count)
+{
+    SWSS_LOG_ENTER();
+
+    // See notification_queue_pop.lua for argument format
+    RedisCommand command;
+    command.beginArgv(5);
+    command.appendArgv("EVALSHA", 7);
+    command.appendArgv(m_shaQueuePop);
+    command.appendArgv("1", 1);
+    command.appendArgv(m_queueName);
+    command.appendArgvInteger(static_cast<long long>(count));
+
+    RedisReply r(m_db, command, REDIS_REPLY_ARRAY);
+    auto reply = r.getContext();
+    if (reply->elements == 0 || reply->element[0]->type != REDIS_REPLY_INTEGER)
+    {
+        SWSS_LOG_THROW("unexpected reply popping notification queue %s", m_queueName.c_str());
+    }
+
+    m_queueRemaining = reply->element[0]->integer;
+    for (size_t i = 1; i < reply->elements; i++)
+    {
+        m_queue.emplace(reply->element[i]->str, reply->element[i]->len);
+    }
+}
+
+uint64_t swss::NotificationConsumer::getDroppedCount()
+{
+    RedisCommand get;
+    get.format("GET %s", NotificationQueue::getDroppedCounterName(m_channel).c_str());
+    RedisReply r(m_db, get);
+    auto reply = r.getContext();
+    if (reply->type != REDIS_REPLY_STRING)
+    {
+        return 0;
+    }
+
+    return std::stoull(std::string(reply->str, reply->len));
 }
 
 void swss::NotificationConsumer::processReply(redisReply *reply)
@@ -134,6 +229,11 @@ void swss::NotificationConsumer::processReply(redisReply *reply)
         throw std::runtime_error("getRedisReply operation failed");
     }
 
+    if (m_queued)
+    {
+        return;
+    }
+
     std::string msg = std::string(reply->element[REDIS_PUBLISH_MESSAGE_INDEX]->str);
 
     SWSS_LOG_DEBUG("got message: %s", msg.c_str());
@@ -145,15 +245,27 @@ void swss::NotificationConsumer::pop(std::string &op, std::string &data, std::ve
 {
     SWSS_LOG_ENTER();
 
+    if (m_queue.empty() && m_queueRemaining > 0)
+    {
+        popQueue(POP_BATCH_SIZE);
+    }
+
     if (m_queue.empty())
     {
         SWSS_LOG_ERROR("notification queue is empty, can't pop");
         throw std::runtime_error("notification queue is empty, can't pop");
     }
 
-    std::string msg = m_queue.front();
+    std::string msg = std::move(m_queue.front());
     m_queue.pop();
 
+    if (m_queued)
+    {
+        // binary payload, no JSON parsing
+        NotificationQueue::decode(msg.data(), msg.size(), op, data, values);
+        return;
+    }
+
     values.clear();
     JSon::readJson(msg, values);
 
@@ -170,6 +282,22 @@ void swss::NotificationConsumer::pops(std::deque<KeyOpFieldsValuesTuple> &vkco)
     SWSS_LOG_ENTER();
 
     vkco.clear();
+    if (m_queued)
+    {
+        while (vkco.size() < POP_BATCH_SIZE && (!m_queue.empty() || m_queueRemaining > 0))
+        {
+            if (m_queue.empty())
+            {
+                popQueue(POP_BATCH_SIZE - vkco.size());
+                continue;
+            }
+
+            vkco.emplace_back();
+            pop(kfvOp(vkco.back()), kfvKey(vkco.back()), kfvFieldsValues(vkco.back()));
+        }
+        return;
+    }
+
     while(!m_queue.empty())
     {
         while(!m_queue.empty())
@@ -198,7 +326,11 @@ void swss::NotificationConsumer::pops(std::deque<KeyOpFieldsValuesTuple> &vkco)
 int swss::NotificationConsumer::peek()
 {
     SWSS_LOG_ENTER();
-    if (m_queue.empty())
+    if (m_queue.empty() && m_queued)
+    {
+        popQueue(POP_BATCH_SIZE);
+    }
+    else if (m_queue.empty())
     {
         // Peek for more data in redis socket
         int rc = swss::peekRedisContext(m_subscribe->getContext());
@@ -23,6 +23,10 @@ class NotificationConsumer : public Selectable
 public:
     NotificationConsumer(swss::DBConnector *db, const std::string &channel, int pri = 100, size_t popBatchSize = DEFAULT_NC_POP_BATCH_SIZE);
 
+    // Consume a queued channel when queued is true, see NotificationQueue.
+    // A queued channel has a single consumer, throw if it already has one.
+    NotificationConsumer(swss::DBConnector *db, const std::string &channel, int pri, size_t popBatchSize, bool queued);
+
     // Pop one or multiple data from the internal queue which fed from redis socket
     // Note:
     //    Ensure data ready before popping, either by select or peek
@@ -36,12 +40,16 @@ public:
     //    -1 - error during peeking redis socket
     int peek();
 
+    // Returns: the number of messages dropped on the full queue of a queued channel
+    uint64_t getDroppedCount();
+
     ~NotificationConsumer() override;
 
     int getFd() override;
     uint64_t readData() override;
     bool hasData() override;
     bool hasCachedData() override;
+    bool initializedWithData() override;
     const size_t POP_BATCH_SIZE;
 
 private:
@@ -51,11 +59,18 @@ private:
 
     void processReply(redisReply *reply);
     void subscribe();
+    void popQueue(size_t count);
 
     swss::DBConnector *m_db;
     swss::DBConnector *m_subscribe;
     std::string m_channel;
     std::queue<std::string> m_queue;
+
+    // Queued channel: the redis list and the notifications left in it
+    bool m_queued;
+    std::string m_queueName;
+    std::string m_shaQueuePop;
+    long long int m_queueRemaining;
 };
 
 }
@@ -1,4 +1,6 @@
 #include "notificationproducer.h"
+#include "notificationqueue.h"
+#include "redisapi.h"
 
 #define NON_BUFFERED_COMMAND_BUFFER_SIZE 1
 
@@ -12,10 +14,47 @@ swss::NotificationProducer::NotificationProducer(swss::RedisPipeline *pipeline,
 {
 }
 
+swss::NotificationProducer::NotificationProducer(swss::DBConnector *db, const std::string &channel, size_t maxQueueLength):
+    NotificationProducer(db, channel)
+{
+    if (maxQueueLength == 0)
+    {
+        SWSS_LOG_THROW("notification queue length of channel %s can't be 0", channel.c_str());
+    }
+
+    m_maxQueueLength = maxQueueLength;
+    m_queueName = NotificationQueue::getQueueName(channel);
+    m_droppedCounterName = NotificationQueue::getDroppedCounterName(channel);
+    m_shaQueuePush = m_pipe->loadRedisScript(loadLuaScript("notification_queue_push.lua"));
+}
+
 int64_t swss::NotificationProducer::send(const std::string &op, const std::string &data, std::vector<FieldValueTuple> &values)
 {
     SWSS_LOG_ENTER();
 
+    if (m_maxQueueLength)
+    {
+        // See notification_queue_push.lua for argument format
+        RedisCommand command;
+        command.beginArgv(7);
+        command.appendArgv("EVALSHA", 7);
+        command.appendArgv(m_shaQueuePush);
+        command.appendArgv("2", 1);
+        command.appendArgv(m_queueName);
+        command.appendArgv(m_droppedCounterName);
+        command.appendArgvInteger(static_cast<long long>(m_maxQueueLength));
+        command.appendArgv(NotificationQueue::encode(op, data, values));
+        RedisReply reply = m_pipe->push(command);
+        reply.checkReplyType(REDIS_REPLY_INTEGER);
+        auto len = reply.getReply<long long int>();
+        if (len == 0)
+        {
+            m_dropped++;
+            SWSS_LOG_WARN("notification queue of channel %s is full, dropped %s", m_channel.c_str(), op.c_str());
+        }
+        return len;
+    }
+
     FieldValueTuple opdata(op, data);
 
     values.insert(values.begin(), opdata);
@@ -42,3 +81,8 @@ int64_t swss::NotificationProducer::send(const std::string &op, const std::strin
     reply.checkReplyType(REDIS_REPLY_INTEGER);
     return reply.getReply<long long int>();
 }
+
+uint64_t swss::NotificationProducer::getDroppedCount() const
+{
+    return m_dropped;
+}
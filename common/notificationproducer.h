@@ -27,9 +27,21 @@ public:
      */
     NotificationProducer(RedisPipeline *pipeline, const std::string &channel, bool buffered = false);
 
-    // Returns: the number of clients that received the message
+    /**
+     * @brief Create NotificationProducer of a queued channel, see NotificationQueue
+     * @param db Pointer to DBConnector
+     * @param channel Channel name
+     * @param maxQueueLength Max notifications waiting for the consumer
+     */
+    NotificationProducer(swss::DBConnector *db, const std::string &channel, size_t maxQueueLength);
+
+    // Returns: the number of clients that received the message,
+    // for a queued channel the queue length or 0 if the queue is full and the message is dropped
     int64_t send(const std::string &op, const std::string &data, std::vector<FieldValueTuple> &values);
 
+    // Returns: the number of messages dropped on a full queue by this producer
+    uint64_t getDroppedCount() const;
+
 private:
 
     NotificationProducer(const NotificationProducer &other);
@@ -39,6 +51,11 @@ private:
     RedisPipeline *m_pipe;
     std::string m_channel;
     bool m_buffered{false};
+    size_t m_maxQueueLength{0};
+    std::string m_shaQueuePush;
+    std::string m_queueName;
+    std::string m_droppedCounterName;
+    uint64_t m_dropped{0};
 };
 
 }
@@ -0,0 +1,45 @@
+#include "notificationqueue.h"
+#include "binaryserializer.h"
+#include "logger.h"
+
+std::string swss::NotificationQueue::getQueueName(const std::string &channel)
+{
+    return channel + "_QUEUE";
+}
+
+std::string swss::NotificationQueue::getDroppedCounterName(const std::string &channel)
+{
+    return channel + "_QUEUE_DROPPED";
+}
+
+std::string swss::NotificationQueue::encode(const std::string &op, const std::string &data, const std::vector<FieldValueTuple> &values)
+{
+    std::vector<KeyOpFieldsValuesTuple> kcos{ KeyOpFieldsValuesTuple(data, SET_COMMAND, values) };
+
+    // The V2 size is an upper bound
+    std::string payload(BinarySerializer::serializedSize(op, "", kcos, BinarySerializer::Format::V2), '\0');
+    size_t size = BinarySerializer::serializeBuffer(&payload[0], payload.size(), op, "", kcos, BinarySerializer::Format::V2);
+    payload.resize(size);
+
+    return payload;
+}
+
+void swss::NotificationQueue::decode(const char *payload, size_t size, std::string &op, std::string &data, std::vector<FieldValueTuple> &values)
+{
+    KcoViewMessage message;
+    BinarySerializer::deserializeBuffer(payload, size, message);
+    if (message.kcos.size() != 1)
+    {
+        SWSS_LOG_THROW("notification has %zu entries, expected 1", message.kcos.size());
+    }
+
+    auto &kco = message.kcos[0];
+    op = message.dbName.str();
+    data = kco.key.str();
+    values.clear();
+    values.reserve(kco.fieldValueCount);
+    for (auto &fv : kco)
+    {
+        values.emplace_back(fv.first.str(), fv.second.str());
+    }
+}
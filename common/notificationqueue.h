@@ -0,0 +1,43 @@
+#ifndef __NOTIFICATIONQUEUE__
+#define __NOTIFICATIONQUEUE__
+
+#include <string>
+#include <vector>
+
+#include "table.h"
+
+namespace swss {
+
+/* Max notifications waiting in a queued channel */
+static constexpr size_t DEFAULT_NOTIFICATION_QUEUE_LENGTH = 65536;
+
+/*
+ * Queued notification channel: the notifications are kept in a redis list
+ * until the consumer pops them, instead of being lost when no consumer
+ * listens or its pub/sub buffer overflows. A full queue rejects the new
+ * notifications and counts them.
+ * A queued channel has a single consumer: the consumer pops the
+ * notifications off the list, so each one is delivered once, not to every
+ * consumer like pub/sub. A second NotificationConsumer of the channel is
+ * rejected while the first one is subscribed.
+ * The notifications are encoded with BinarySerializer V2, op and data
+ * take the place of the table name and the key.
+ */
+class NotificationQueue
+{
+public:
+    /* Redis list of the channel, also the channel waking up the consumer */
+    static std::string getQueueName(const std::string &channel);
+
+    /* Redis counter of the notifications dropped on a full queue */
+    static std::string getDroppedCounterName(const std::string &channel);
+
+    static std::string encode(const std::string &op, const std::string &data, const std::vector<FieldValueTuple> &values);
+
+    /* Throw if the payload is not a notification */
+    static void decode(const char *payload, size_t size, std::string &op, std::string &data, std::vector<FieldValueTuple> &values);
+};
+
+}
+
+#endif // __NOTIFICATIONQUEUE__
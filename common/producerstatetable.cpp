@@ -30,6 +30,12 @@ ProducerStateTable::ProducerStateTable(RedisPipeline *pipeline, const string &ta
     , m_pipeowned(false)
     , m_tempViewActive(false)
     , m_pipe(pipeline)
+    , m_coalesced(false)
+    , m_coalescedCount(0)
+    , m_channelName(getChannelName(pipeline->getDbId()))
+    , m_keySetName(getKeySetName())
+    , m_delKeySetName(getDelKeySetName())
+    , m_stateHashTablePrefix(getStateHashPrefix() + getTableName() + getTableNameSeparator())
 {
     reloadRedisScript();
 
@@ -48,6 +54,19 @@ ProducerStateTable::ProducerStateTable(RedisPipeline *pipeline, const string &ta
 
 ProducerStateTable::~ProducerStateTable()
 {
+    if (!m_coalescedOps.empty())
+    {
+        // the pipeline flushes the commands when it is destroyed
+        try
+        {
+            flushCoalesced();
+        }
+        catch (const std::exception& e)
+        {
+            SWSS_LOG_ERROR("failed to flush %zu operations of table %s: %s", m_coalescedOps.size(), getTableName().c_str(), e.what());
+        }
+    }
+
     if (m_pipeowned)
     {
         delete m_pipe;
@@ -69,10 +88,11 @@ void ProducerStateTable::reloadRedisScript()
 
     // num in luaSet and luaDel means number of elements that were added to the key set,
     // not including all the elements already present into the set.
+    // The state hash is passed once as KEYS[3], the field count is derived from ARGV
     string luaSet =
         "local added = redis.call('SADD', KEYS[2], ARGV[2])\n"
-        "for i = 0, #KEYS - 3 do\n"
-        "    redis.call('HSET', KEYS[3 + i], ARGV[3 + i * 2], ARGV[4 + i * 2])\n"
+        "for i = 0, #ARGV / 2 - 2 do\n"
+        "    redis.call('HSET', KEYS[3], ARGV[3 + i * 2], ARGV[4 + i * 2])\n"
         "end\n";
 
     string luaDel =
@@ -101,6 +121,26 @@ void ProducerStateTable::reloadRedisScript()
         "    redis.call('DEL', KEYS[4] .. KEYS[5 + i])\n"
         "end\n";
 
+    // ARGV[idx] is 'S' followed by the field count and fields, or 'D'
+    string luaBatchedApply =
+        "local added = 0\n"
+        "local idx = 2\n"
+        "for i = 0, #KEYS - 5 do\n"
+        "    local key = KEYS[5 + i]\n"
+        "    added = added + redis.call('SADD', KEYS[2], key)\n"
+        "    if ARGV[idx] == 'D' then\n"
+        "        redis.call('SADD', KEYS[3], key)\n"
+        "        redis.call('DEL', KEYS[4] .. key)\n"
+        "        idx = idx + 1\n"
+        "    else\n"
+        "        local n = tonumber(ARGV[idx + 1])\n"
+        "        for j = 0, n - 1 do\n"
+        "            redis.call('HSET', KEYS[4] .. key, ARGV[idx + j * 2 + 2], ARGV[idx + j * 2 + 3])\n"
+        "        end\n"
+        "        idx = idx + n * 2 + 2\n"
+        "    end\n"
+        "end\n";
+
     if (!m_flushPub || !m_buffered)
     {
         string luaPub =
@@ -111,6 +151,7 @@ void ProducerStateTable::reloadRedisScript()
         luaDel += luaPub;
         luaBatchedSet += luaPub;
         luaBatchedDel += luaPub;
+        luaBatchedApply += luaPub;
     }
 
     /* 3. load redis script based on the lua string */
@@ -118,14 +159,28 @@ void ProducerStateTable::reloadRedisScript()
     m_shaDel = m_pipe->loadRedisScript(luaDel);
     m_shaBatchedSet = m_pipe->loadRedisScript(luaBatchedSet);
     m_shaBatchedDel = m_pipe->loadRedisScript(luaBatchedDel);
+    m_shaBatchedApply = m_pipe->loadRedisScript(luaBatchedApply);
 }
 
 void ProducerStateTable::setBuffered(bool buffered)
 {
+    if (!buffered)
+    {
+        flushCoalesced();
+    }
     m_buffered = buffered;
     reloadRedisScript();
 }
 
+void ProducerStateTable::setCoalesced(bool coalesced)
+{
+    if (!coalesced)
+    {
+        flushCoalesced();
+    }
+    m_coalesced = coalesced;
+}
+
 void ProducerStateTable::set(const string &key, const vector<FieldValueTuple> &values,
                  const string &op /*= SET_COMMAND*/, const string &prefix)
 {
@@ -139,28 +194,30 @@ void ProducerStateTable::set(const string &key, const vector<FieldValueTuple> &v
         return;
     }
 
-    // Assembly redis command args into a string vector
-    vector<string> args;
-    args.emplace_back("EVALSHA");
-    args.emplace_back(m_shaSet);
-    args.emplace_back(to_string(values.size() + 2));
-    args.emplace_back(getChannelName(m_pipe->getDbId()));
-    args.emplace_back(getKeySetName());
-
-    args.insert(args.end(), values.size(), getStateHashPrefix() + getKeyName(key));
+    if (isCoalescing())
+    {
+        coalesceSet(key, values);
+        return;
+    }
 
-    args.emplace_back("G");
-    args.emplace_back(key);
+    // Assembly redis command in place, see luaSet for argument format
+    m_command.beginArgv(values.size() * 2 + 8);
+    m_command.appendArgv("EVALSHA", 7);
+    m_command.appendArgv(m_shaSet);
+    m_command.appendArgv("3", 1);
+    m_command.appendArgv(m_channelName);
+    m_command.appendArgv(m_keySetName);
+    appendStateHashKey(key);
+    m_command.appendArgv("G", 1);
+    m_command.appendArgv(key);
     for (const auto& iv: values)
     {
-        args.emplace_back(fvField(iv));
-        args.emplace_back(fvValue(iv));
+        m_command.appendArgv(fvField(iv));
+        m_command.appendArgv(fvValue(iv));
     }
 
     // Invoke redis command
-    RedisCommand command;
-    command.format(args);
-    m_pipe->push(command, REDIS_REPLY_NIL);
+    m_pipe->push(m_command, REDIS_REPLY_NIL);
     if (!m_buffered)
     {
         m_pipe->flush();
@@ -176,24 +233,28 @@ void ProducerStateTable::del(const string &key, const string &op /*= DEL_COMMAND
         return;
     }
 
-    // Assembly redis command args into a string vector
-    vector<string> args;
-    args.emplace_back("EVALSHA");
-    args.emplace_back(m_shaDel);
-    args.emplace_back("4");
-    args.emplace_back(getChannelName(m_pipe->getDbId()));
-    args.emplace_back(getKeySetName());
-    args.emplace_back(getStateHashPrefix() + getKeyName(key));
-    args.emplace_back(getDelKeySetName());
-    args.emplace_back("G");
-    args.emplace_back(key);
-    args.emplace_back("''");
-    args.emplace_back("''");
+    if (isCoalescing())
+    {
+        coalesceDel(key);
+        return;
+    }
+
+    // Assembly redis command in place, see luaDel for argument format
+    m_command.beginArgv(11);
+    m_command.appendArgv("EVALSHA", 7);
+    m_command.appendArgv(m_shaDel);
+    m_command.appendArgv("4", 1);
+    m_command.appendArgv(m_channelName);
+    m_command.appendArgv(m_keySetName);
+    appendStateHashKey(key);
+    m_command.appendArgv(m_delKeySetName);
+    m_command.appendArgv("G", 1);
+    m_command.appendArgv(key);
+    m_command.appendArgv("''", 2);
+    m_command.appendArgv("''", 2);
 
     // Invoke redis command
-    RedisCommand command;
-    command.format(args);
-    m_pipe->push(command, REDIS_REPLY_NIL);
+    m_pipe->push(m_command, REDIS_REPLY_NIL);
     if (!m_buffered)
     {
         m_pipe->flush();
@@ -216,37 +277,55 @@ void ProducerStateTable::set(const std::vector<KeyOpFieldsValuesTuple>& values)
         return;
     }
 
-    // Assembly redis command args into a string vector
-    vector<string> args;
-    args.emplace_back("EVALSHA");
-    args.emplace_back(m_shaBatchedSet);
-    args.emplace_back(to_string(values.size() + 3));
-    args.emplace_back(getChannelName(m_pipe->getDbId()));
-    args.emplace_back(getKeySetName());
-    args.emplace_back(getStateHashPrefix() + getTableName() + getTableNameSeparator());
+    if (isCoalescing())
+    {
+        for (const auto &value : values)
+        {
+            coalesceSet(kfvKey(value), kfvFieldsValues(value));
+        }
+        return;
+    }
+
+    pushBatchedSet(values);
+    if (!m_buffered)
+    {
+        m_pipe->flush();
+    }
+}
+
+void ProducerStateTable::pushBatchedSet(const std::vector<KeyOpFieldsValuesTuple>& values)
+{
+    size_t argc = values.size() * 2 + 7;
     for (const auto &value : values)
     {
-        args.emplace_back(kfvKey(value));
+        argc += kfvFieldsValues(value).size() * 2;
     }
-    args.emplace_back("G");
+
+    // Assembly redis command in place, see luaBatchedSet for argument format
+    m_command.beginArgv(argc);
+    m_command.appendArgv("EVALSHA", 7);
+    m_command.appendArgv(m_shaBatchedSet);
+    m_command.appendArgvInteger(static_cast<long long>(values.size() + 3));
+    m_command.appendArgv(m_channelName);
+    m_command.appendArgv(m_keySetName);
+    m_command.appendArgv(m_stateHashTablePrefix);
     for (const auto &value : values)
     {
-        args.emplace_back(to_string(kfvFieldsValues(value).size()));
+        m_command.appendArgv(kfvKey(value));
+    }
+    m_command.appendArgv("G", 1);
+    for (const auto &value : values)
+    {
+        m_command.appendArgvInteger(static_cast<long long>(kfvFieldsValues(value).size()));
         for (const auto &iv : kfvFieldsValues(value))
         {
-            args.emplace_back(fvField(iv));
-            args.emplace_back(fvValue(iv));
+            m_command.appendArgv(fvField(iv));
+            m_command.appendArgv(fvValue(iv));
         }
     }
 
     // Invoke redis command
-    RedisCommand command;
-    command.format(args);
-    m_pipe->push(command, REDIS_REPLY_NIL);
-    if (!m_buffered)
-    {
-        m_pipe->flush();
-    }
+    m_pipe->push(m_command, REDIS_REPLY_NIL);
 }
 
 void ProducerStateTable::del(const std::vector<std::string>& keys)
@@ -261,38 +340,222 @@ void ProducerStateTable::del(const std::vector<std::string>& keys)
         return;
     }
 
-    // Assembly redis command args into a string vector
-    vector<string> args;
-    args.emplace_back("EVALSHA");
-    args.emplace_back(m_shaBatchedDel);
-    args.emplace_back(to_string(keys.size() + 4));
-    args.emplace_back(getChannelName(m_pipe->getDbId()));
-    args.emplace_back(getKeySetName());
-    args.emplace_back(getDelKeySetName());
-    args.emplace_back(getStateHashPrefix() + getTableName() + getTableNameSeparator());
+    if (isCoalescing())
+    {
+        for (const auto &key : keys)
+        {
+            coalesceDel(key);
+        }
+        return;
+    }
+
+    pushBatchedDel(keys);
+    if (!m_buffered)
+    {
+        m_pipe->flush();
+    }
+}
+
+void ProducerStateTable::pushBatchedDel(const std::vector<std::string>& keys)
+{
+    // Assembly redis command in place, see luaBatchedDel for argument format
+    m_command.beginArgv(keys.size() + 8);
+    m_command.appendArgv("EVALSHA", 7);
+    m_command.appendArgv(m_shaBatchedDel);
+    m_command.appendArgvInteger(static_cast<long long>(keys.size() + 4));
+    m_command.appendArgv(m_channelName);
+    m_command.appendArgv(m_keySetName);
+    m_command.appendArgv(m_delKeySetName);
+    m_command.appendArgv(m_stateHashTablePrefix);
     for (const auto &key : keys)
     {
-        args.emplace_back(key);
+        m_command.appendArgv(key);
     }
-    args.emplace_back("G");
+    m_command.appendArgv("G", 1);
 
     // Invoke redis command
-    RedisCommand command;
-    command.format(args);
-    m_pipe->push(command, REDIS_REPLY_NIL);
+    m_pipe->push(m_command, REDIS_REPLY_NIL);
+}
+
+void ProducerStateTable::apply(const std::vector<KeyOpFieldsValuesTuple>& values)
+{
+    // A DEL takes its key and op, a SET also its field count and fields
+    size_t argc = values.size() * 2 + 8;
+    for (const auto &value : values)
+    {
+        const auto &op = kfvOp(value);
+        if (op == SET_COMMAND)
+        {
+            argc += kfvFieldsValues(value).size() * 2 + 1;
+        }
+        else if (op != DEL_COMMAND)
+        {
+            SWSS_LOG_THROW("invalid op %s of key %s in table %s", op.c_str(), kfvKey(value).c_str(), getTableName().c_str());
+        }
+    }
+
+    if (m_tempViewActive || isCoalescing())
+    {
+        for (const auto &value : values)
+        {
+            if (kfvOp(value) == SET_COMMAND)
+            {
+                set(kfvKey(value), kfvFieldsValues(value));
+            }
+            else
+            {
+                del(kfvKey(value));
+            }
+        }
+        return;
+    }
+
+    // Assembly redis command in place, see luaBatchedApply for argument format
+    m_command.beginArgv(argc);
+    m_command.appendArgv("EVALSHA", 7);
+    m_command.appendArgv(m_shaBatchedApply);
+    m_command.appendArgvInteger(static_cast<long long>(values.size() + 4));
+    m_command.appendArgv(m_channelName);
+    m_command.appendArgv(m_keySetName);
+    m_command.appendArgv(m_delKeySetName);
+    m_command.appendArgv(m_stateHashTablePrefix);
+    for (const auto &value : values)
+    {
+        m_command.appendArgv(kfvKey(value));
+    }
+    m_command.appendArgv("G", 1);
+    for (const auto &value : values)
+    {
+        if (kfvOp(value) == DEL_COMMAND)
+        {
+            m_command.appendArgv("D", 1);
+            continue;
+        }
+
+        m_command.appendArgv("S", 1);
+        m_command.appendArgvInteger(static_cast<long long>(kfvFieldsValues(value).size()));
+        for (const auto &iv : kfvFieldsValues(value))
+        {
+            m_command.appendArgv(fvField(iv));
+            m_command.appendArgv(fvValue(iv));
+        }
+    }
+
+    // Invoke redis command
+    m_pipe->push(m_command, REDIS_REPLY_NIL);
     if (!m_buffered)
     {
         m_pipe->flush();
     }
 }
 
+ProducerStateTable::CoalescedOp& ProducerStateTable::coalescedOp(const string &key)
+{
+    auto it = m_coalescedIndex.find(key);
+    if (it != m_coalescedIndex.end())
+    {
+        m_coalescedCount++;
+        return m_coalescedOps[it->second];
+    }
+
+    if (m_coalescedOps.size() >= m_pipe->COMMAND_MAX)
+    {
+        // bounds the memory and the size of the batched scripts
+        flushCoalesced();
+    }
+
+    m_coalescedIndex.emplace(key, m_coalescedOps.size());
+    m_coalescedOps.push_back(CoalescedOp{key, false, false, {}});
+    return m_coalescedOps.back();
+}
+
+void ProducerStateTable::coalesceSet(const string &key, const vector<FieldValueTuple> &values)
+{
+    auto &op = coalescedOp(key);
+    op.set = true;
+    for (const auto &iv : values)
+    {
+        // entries have a few fields, a linear search beats a map
+        auto field = find_if(op.fields.begin(), op.fields.end(), [&iv](const FieldValueTuple &fv) {
+            return fvField(fv) == fvField(iv);
+        });
+        if (field != op.fields.end())
+        {
+            fvValue(*field) = fvValue(iv);
+        }
+        else
+        {
+            op.fields.push_back(iv);
+        }
+    }
+}
+
+void ProducerStateTable::coalesceDel(const string &key)
+{
+    // The consumer sees a DEL, the earlier SETs are gone with the state hash
+    auto &op = coalescedOp(key);
+    op.del = true;
+    op.set = false;
+    op.fields.clear();
+}
+
+void ProducerStateTable::flushCoalesced()
+{
+    if (m_coalescedOps.empty())
+    {
+        return;
+    }
+
+    // Deletes go first, a SET after a DEL of the same key recreates it
+    vector<string> keysToDel;
+    vector<KeyOpFieldsValuesTuple> valuesToSet;
+    for (auto &op : m_coalescedOps)
+    {
+        if (op.del)
+        {
+            keysToDel.push_back(op.key);
+        }
+        if (op.set)
+        {
+            valuesToSet.emplace_back(std::move(op.key), SET_COMMAND, std::move(op.fields));
+        }
+    }
+    m_coalescedOps.clear();
+    m_coalescedIndex.clear();
+
+    if (!keysToDel.empty())
+    {
+        pushBatchedDel(keysToDel);
+    }
+    if (!valuesToSet.empty())
+    {
+        pushBatchedSet(valuesToSet);
+    }
+}
+
+void ProducerStateTable::appendStateHashKey(const string &key)
+{
+    // Same as getStateHashPrefix() + getKeyName(key), without temporary strings
+    if (key.empty())
+    {
+        m_command.appendArgv(getStateHashPrefix(), getTableName());
+    }
+    else
+    {
+        m_command.appendArgv(m_stateHashTablePrefix, key);
+    }
+}
+
 void ProducerStateTable::flush()
 {
+    flushCoalesced();
     m_pipe->flush();
 }
 
 int64_t ProducerStateTable::count()
 {
+    flushCoalesced();
+
     RedisCommand cmd;
     cmd.format("SCARD %s", getKeySetName().c_str());
     RedisReply r = m_pipe->push(cmd);
@@ -305,6 +568,9 @@ int64_t ProducerStateTable::count()
 // ConsumerState may have got the notification from PUBLISH, but will see no data popped.
 void ProducerStateTable::clear()
 {
+    m_coalescedOps.clear();
+    m_coalescedIndex.clear();
+
     // Assembly redis command args into a string vector
     vector<string> args;
     args.emplace_back("EVALSHA");
@@ -327,6 +593,7 @@ void ProducerStateTable::create_temp_view()
     {
         SWSS_LOG_WARN("create_temp_view() called for table %s when another temp view is under work, %zd objects in existing temp view will be discarded.", getTableName().c_str(), m_tempViewState.size());
     }
+    flushCoalesced();
     m_tempViewActive = true;
     m_tempViewState.clear();
 }
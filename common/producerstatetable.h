@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include "table.h"
 #include "redispipeline.h"
 
@@ -16,6 +17,20 @@ public:
     virtual ~ProducerStateTable();
 
     void setBuffered(bool buffered);
+
+    /*
+     * In buffered mode, keep the operations until flush() and merge the
+     * operations on the same key: the fields of the SETs are merged and a
+     * DEL drops the earlier SETs. flush() writes them with one batched DEL
+     * and one batched SET.
+     * Only flush() of this table drains the buffer, flushing the pipeline
+     * directly doesn't. The buffer is written to the pipeline once it holds
+     * as many keys as the pipeline holds commands.
+     */
+    void setCoalesced(bool coalesced);
+
+    /* Operations merged into an earlier operation on the same key */
+    uint64_t getCoalescedCount() const { return m_coalescedCount; }
     /* Implements set() and del() commands using notification messages */
     virtual void set(const std::string &key,
                      const std::vector<FieldValueTuple> &values,
@@ -42,6 +57,13 @@ public:
 
     virtual void del(const std::vector<std::string>& keys);
 
+    /*
+     * Batched SET and DEL operations, applied in order by one redis script
+     * with one notification. The op of each entry is SET_COMMAND or
+     * DEL_COMMAND, the fields of a DEL are ignored.
+     */
+    virtual void apply(const std::vector<KeyOpFieldsValuesTuple>& values);
+
     void flush();
 
     int64_t count();
@@ -61,11 +83,43 @@ private:
     std::string m_shaDel;
     std::string m_shaBatchedSet;
     std::string m_shaBatchedDel;
+    std::string m_shaBatchedApply;
     std::string m_shaClear;
     std::string m_shaApplyView;
     TableDump m_tempViewState;
 
+    // Pending operation of a key in coalesced mode
+    struct CoalescedOp
+    {
+        std::string key;
+        bool del;   // the key is deleted before the fields are set
+        bool set;
+        std::vector<FieldValueTuple> fields;
+    };
+
+    bool m_coalesced;
+    uint64_t m_coalescedCount;
+    // Pending operations in the order their key was first written
+    std::vector<CoalescedOp> m_coalescedOps;
+    std::unordered_map<std::string, size_t> m_coalescedIndex;
+
+    // Names and command buffer reused by set() and del(), so that
+    // formatting a command does not allocate on the hot path
+    std::string m_channelName;
+    std::string m_keySetName;
+    std::string m_delKeySetName;
+    std::string m_stateHashTablePrefix;
+    RedisCommand m_command;
+
     void reloadRedisScript(); // redis script may change if m_buffered changes
+    void appendStateHashKey(const std::string &key);
+    bool isCoalescing() const { return m_coalesced && m_buffered && !m_tempViewActive; }
+    CoalescedOp& coalescedOp(const std::string &key);
+    void coalesceSet(const std::string &key, const std::vector<FieldValueTuple> &values);
+    void coalesceDel(const std::string &key);
+    void flushCoalesced();
+    void pushBatchedSet(const std::vector<KeyOpFieldsValuesTuple>& values);
+    void pushBatchedDel(const std::vector<std::string>& keys);
 };
 
 }
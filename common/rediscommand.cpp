@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <vector>
 #include <hiredis/hiredis.h>
 #include "rediscommand.h"
@@ -9,7 +10,8 @@ namespace swss {
 
 RedisCommand::RedisCommand()
  : temp(NULL),
-   len(0)
+   len(0),
+   pendingArgs(0)
 {
 }
 
@@ -18,7 +20,7 @@ RedisCommand::~RedisCommand()
     redisFreeCommand(temp);
 }
 
-void RedisCommand::format(const char *fmt, ...)
+void RedisCommand::releaseTemp()
 {
     if (temp != nullptr)
     {
@@ -26,6 +28,13 @@ void RedisCommand::format(const char *fmt, ...)
         temp = nullptr;
     }
     len = 0;
+    buffer.clear();
+    pendingArgs = 0;
+}
+
+void RedisCommand::format(const char *fmt, ...)
+{
+    releaseTemp();
 
     va_list ap;
     va_start(ap, fmt);
@@ -41,12 +50,7 @@ void RedisCommand::format(const char *fmt, ...)
 
 void RedisCommand::formatArgv(int argc, const char **argv, const size_t *argvlen)
 {
-    if (temp != nullptr)
-    {
-        redisFreeCommand(temp);
-        temp = nullptr;
-    }
-    len = 0;
+    releaseTemp();
 
     long long ret = redisFormatCommandArgv(&temp, argc, argv, argvlen);
     if (ret == -1) {
@@ -137,18 +141,81 @@ void RedisCommand::formatDEL(const std::vector<std::string>& keys)
     format(args);
 }
 
+void RedisCommand::appendHeader(char type, long long value)
+{
+    char header[32];
+    int n = snprintf(header, sizeof(header), "%c%lld\r\n", type, value);
+    buffer.append(header, static_cast<size_t>(n));
+}
+
+void RedisCommand::beginArgv(size_t argc)
+{
+    if (argc == 0) throw std::invalid_argument("empty command");
+
+    // clear() keeps the capacity of the buffer for the next command
+    releaseTemp();
+    appendHeader('*', static_cast<long long>(argc));
+    pendingArgs = argc;
+}
+
+void RedisCommand::appendArgv(const char *arg, size_t arglen)
+{
+    if (pendingArgs == 0)
+    {
+        throw std::logic_error("Too many arguments appended to redis command");
+    }
+
+    appendHeader('$', static_cast<long long>(arglen));
+    buffer.append(arg, arglen);
+    buffer.append("\r\n", 2);
+    pendingArgs--;
+}
+
+void RedisCommand::appendArgv(const std::string &arg)
+{
+    appendArgv(arg.data(), arg.size());
+}
+
+void RedisCommand::appendArgv(const std::string &prefix, const std::string &suffix)
+{
+    if (pendingArgs == 0)
+    {
+        throw std::logic_error("Too many arguments appended to redis command");
+    }
+
+    appendHeader('$', static_cast<long long>(prefix.size() + suffix.size()));
+    buffer.append(prefix);
+    buffer.append(suffix);
+    buffer.append("\r\n", 2);
+    pendingArgs--;
+}
+
+void RedisCommand::appendArgvInteger(long long value)
+{
+    char number[24];
+    int n = snprintf(number, sizeof(number), "%lld", value);
+    appendArgv(number, static_cast<size_t>(n));
+}
+
 int RedisCommand::appendTo(redisContext *ctx) const
 {
+    if (pendingArgs != 0)
+    {
+        throw std::logic_error("Redis command is missing arguments");
+    }
+
     return redisAppendFormattedCommand(ctx, c_str(), length());
 }
 
 std::string RedisCommand::toPrintableString() const
 {
-    return binary_to_printable(temp, len);
+    return binary_to_printable(c_str(), length());
 }
 
 const char *RedisCommand::c_str() const
 {
+    if (temp == nullptr)
+        return buffer.empty() ? nullptr : buffer.data();
     if (len == 0)
         return nullptr;
     return temp;
@@ -156,6 +223,8 @@ const char *RedisCommand::c_str() const
 
 size_t RedisCommand::length() const
 {
+    if (temp == nullptr)
+        return buffer.size();
     if (len <= 0)
         return 0;
     return static_cast<size_t>(len);
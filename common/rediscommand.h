@@ -69,18 +69,42 @@ public:
     /* Format DEL multiple keys command */
     void formatDEL(const std::vector<std::string>& keys);
 
+    /*
+     * Incrementally format a command of argc arguments in RESP format.
+     * The encoding buffer is kept between commands, so re-formatting a
+     * command of similar size does not allocate. Exactly argc arguments
+     * must be appended before the command is used.
+     */
+    void beginArgv(size_t argc);
+    void appendArgv(const char *arg, size_t arglen);
+    void appendArgv(const std::string &arg);
+
+    /* Append one argument made of prefix immediately followed by suffix */
+    void appendArgv(const std::string &prefix, const std::string &suffix);
+
+    /* Append one argument holding the decimal representation of value */
+    void appendArgvInteger(long long value);
+
     int appendTo(redisContext *ctx) const;
 
     std::string toPrintableString() const;
 
+    /* Size of the formatted command in bytes */
+    size_t length() const;
+
 protected:
     const char *c_str() const;
 
-    size_t length() const;
-
 private:
     char *temp;
     int len;
+
+    /* RESP buffer used by beginArgv()/appendArgv() */
+    std::string buffer;
+    size_t pendingArgs;
+
+    void releaseTemp();
+    void appendHeader(char type, long long value);
 };
 
 template<typename InputIterator>
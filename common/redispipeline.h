@@ -2,31 +2,62 @@
 
 #include <string>
 #include <queue>
+#include <vector>
+#include <memory>
 #include <unordered_set>
 #include <functional>
 #include <chrono>
+#include <system_error>
 #include <iostream>
 #include "redisreply.h"
 #include "rediscommand.h"
 #include "dbconnector.h"
 #include "logger.h"
+#include "selectable.h"
+#include "selectabletimer.h"
 
 #include "unistd.h"
+#include "fcntl.h"
 #include "sys/syscall.h"
+#include "sys/epoll.h"
 #define gettid() syscall(SYS_gettid)
 
 namespace swss {
 
+/*
+ * Buffered commands are flushed as soon as any limit is reached,
+ * a zero limit is disabled.
+ */
+struct RedisPipelineFlushPolicy
+{
+    size_t maxCommands = 0;
+    size_t maxBytes = 0;        // total size of the formatted commands
+    uint64_t maxAgeMs = 0;      // age of the oldest buffered command
+};
+
 class RedisPipeline {
 public:
     const size_t COMMAND_MAX;
     static constexpr int NEWCONNECTOR_TIMEOUT = 0;
 
+    /*
+     * Invoked once per batch flushed in async mode, after all its replies
+     * are drained. The argument is empty on success, otherwise it describes
+     * the first failed command of the batch.
+     */
+    typedef std::function<void(const std::string &error)> FlushCallback;
+
     RedisPipeline(const DBConnector *db, size_t sz = 128)
         : COMMAND_MAX(sz)
         , m_remaining(0)
         , m_shaPub("")
+        , m_async(false)
+        , m_inflight(0)
+        , m_pendingWrite(false)
+        , m_asyncFd(-1)
+        , m_bufferedBytes(0)
     {
+        m_flushPolicy.maxCommands = sz;
         m_db = db->newConnector(NEWCONNECTOR_TIMEOUT);
         initializeOwnerTid();
         lastHeartBeat = std::chrono::steady_clock::now();
@@ -43,6 +74,7 @@ public:
                 try
                 {
                     flush();
+                    waitAsyncReplies();
                 }
                 catch (const std::exception& e)
                 {
@@ -54,6 +86,10 @@ public:
                 SWSS_LOG_NOTICE("RedisPipeline dtor is called from another thread, possibly due to exit(), Database: %s", dbName.c_str());
             }
 
+            if (m_asyncFd >= 0)
+            {
+                close(m_asyncFd);
+            }
             delete m_db;
         }
         catch (const std::exception& e)
@@ -81,14 +117,20 @@ public:
                     // ref: https://github.com/redis/hiredis/blob/master/hiredis.c
                     throw std::bad_alloc();
                 }
+                if (m_remaining == 0)
+                {
+                    m_firstBuffered = std::chrono::steady_clock::now();
+                }
                 m_expectedTypes.push(expectedType);
                 m_remaining++;
+                m_bufferedBytes += command.length();
                 mayflush();
                 return NULL;
             }
             default:
             {
                 flush();
+                waitAsyncReplies();
                 RedisReply r(m_db, command, expectedType);
                 return r.release();
             }
@@ -98,10 +140,43 @@ public:
     redisReply *push(const RedisCommand& command)
     {
         flush();
+        waitAsyncReplies();
         RedisReply r(m_db, command);
         return r.release();
     }
 
+    /*
+     * Send all the commands in one pipeline and collect their replies in
+     * order, so that the batch costs a single round trip.
+     */
+    std::vector<std::unique_ptr<RedisReply>> pushBatch(const std::vector<RedisCommand>& commands)
+    {
+        flush();
+        waitAsyncReplies();
+
+        redisContext *ctx = m_db->getContext();
+        for (const auto &command : commands)
+        {
+            if (command.appendTo(ctx) != REDIS_OK)
+            {
+                throw std::bad_alloc();
+            }
+        }
+
+        std::vector<std::unique_ptr<RedisReply>> replies;
+        replies.reserve(commands.size());
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            redisReply *reply = NULL;
+            if (redisGetReply(ctx, (void**)&reply) != REDIS_OK)
+            {
+                throw RedisError("Failed to redisGetReply in RedisPipeline::pushBatch", ctx);
+            }
+            replies.emplace_back(new RedisReply(reply));
+        }
+        return replies;
+    }
+
     std::string loadRedisScript(const std::string& script)
     {
         RedisCommand loadcmd;
@@ -117,6 +192,9 @@ public:
     {
         if (m_remaining == 0) return NULL;
 
+        // The replies of the async batches come first
+        waitAsyncReplies();
+
         redisReply *reply;
         int rc = redisGetReply(m_db->getContext(), (void**)&reply);
         if (rc != REDIS_OK)
@@ -144,6 +222,13 @@ public:
             return;
         }
 
+        m_bufferedBytes = 0;
+        if (m_async)
+        {
+            flushAsync();
+            return;
+        }
+
         while(m_remaining)
         {
             // Construct an object to use its dtor, so that resource is released
@@ -158,6 +243,153 @@ public:
         return m_remaining;
     }
 
+    // Bytes of the buffered commands not yet written to the socket
+    size_t getBufferedBytes() const
+    {
+        return m_bufferedBytes;
+    }
+
+    // Milliseconds since the oldest buffered command was pushed, 0 if none
+    uint64_t getBufferedAge(std::chrono::time_point<std::chrono::steady_clock> tcurrent=std::chrono::steady_clock::now()) const
+    {
+        if (m_remaining == 0)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(tcurrent - m_firstBuffered).count());
+    }
+
+    void setFlushPolicy(const RedisPipelineFlushPolicy &policy)
+    {
+        m_flushPolicy = policy;
+        mayflush();
+    }
+
+    const RedisPipelineFlushPolicy &getFlushPolicy() const
+    {
+        return m_flushPolicy;
+    }
+
+    // Flush if the oldest buffered command is older than the policy allows
+    bool flushIfExpired()
+    {
+        if (m_flushPolicy.maxAgeMs == 0 || getBufferedAge() < m_flushPolicy.maxAgeMs)
+        {
+            return false;
+        }
+        flush();
+        return true;
+    }
+
+    /*
+     * In async mode flush() only writes the buffered commands to the socket,
+     * the replies are drained later by readAsyncReplies() when the connection
+     * becomes readable, e.g. from a Select loop via RedisPipelineSelectable.
+     * Synchronous commands and the destructor still wait for all replies.
+     */
+    void setAsync(bool async, FlushCallback callback = nullptr)
+    {
+        if (!async)
+        {
+            flush();
+            waitAsyncReplies();
+        }
+        m_async = async;
+        m_flushCallback = callback;
+    }
+
+    bool isAsync() const
+    {
+        return m_async;
+    }
+
+    // Number of flushed commands whose replies are not drained yet
+    size_t getInflightCount() const
+    {
+        return m_inflight;
+    }
+
+    int getFd()
+    {
+        return m_db->getContext()->fd;
+    }
+
+    /*
+     * Readable when replies arrived, or the socket became writable while a
+     * flush is only partly written, for RedisPipelineSelectable
+     */
+    int getAsyncFd()
+    {
+        if (m_asyncFd < 0)
+        {
+            m_asyncFd = epoll_create1(EPOLL_CLOEXEC);
+            if (m_asyncFd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "epoll_create1 failed in RedisPipeline::getAsyncFd");
+            }
+
+            struct epoll_event ev = {};
+            ev.events = m_pendingWrite ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT) : static_cast<uint32_t>(EPOLLIN);
+            if (epoll_ctl(m_asyncFd, EPOLL_CTL_ADD, getFd(), &ev) < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "epoll_ctl failed in RedisPipeline::getAsyncFd");
+            }
+        }
+        return m_asyncFd;
+    }
+
+    // true while the commands of an async flush are not fully written
+    bool hasPendingWrite() const
+    {
+        return m_pendingWrite;
+    }
+
+    // Finish the pending write and consume the replies available, never blocks
+    void readAsyncReplies()
+    {
+        redisContext *ctx = m_db->getContext();
+        NonBlocking nonBlocking(ctx);
+        if (m_pendingWrite)
+        {
+            writeAsync();
+        }
+
+        if (redisBufferRead(ctx) != REDIS_OK)
+        {
+            throw RedisError("Failed to redisBufferRead in RedisPipeline::readAsyncReplies", ctx);
+        }
+
+        while (m_inflight > 0)
+        {
+            redisReply *reply = NULL;
+            if (redisGetReplyFromReader(ctx, (void**)&reply) != REDIS_OK)
+            {
+                throw RedisError("Failed to redisGetReplyFromReader in RedisPipeline::readAsyncReplies", ctx);
+            }
+            if (reply == NULL)
+            {
+                break;
+            }
+            completeAsyncReply(reply);
+        }
+    }
+
+    // Block until the replies of every flushed command are drained
+    void waitAsyncReplies()
+    {
+        // redisGetReply() writes the rest of a pending flush
+        setPendingWrite(false);
+        while (m_inflight > 0)
+        {
+            redisReply *reply = NULL;
+            if (redisGetReply(m_db->getContext(), (void**)&reply) != REDIS_OK)
+            {
+                throw RedisError("Failed to redisGetReply in RedisPipeline::waitAsyncReplies", m_db->getContext());
+            }
+            completeAsyncReply(reply);
+        }
+    }
+
     int getDbId()
     {
         return m_db->getDbId();
@@ -215,11 +447,225 @@ private:
     std::chrono::time_point<std::chrono::steady_clock> lastHeartBeat; // marks the timestamp of latest pipeline flush being invoked
     std::unordered_set<std::string> m_channels;
 
+    bool m_async;
+    FlushCallback m_flushCallback;
+    size_t m_inflight;
+    std::queue<int> m_asyncExpectedTypes; // of the flushed commands whose replies are not drained
+    bool m_pendingWrite;
+    int m_asyncFd;
+    std::queue<size_t> m_inflightBatches; // number of undrained replies of every flushed batch
+    std::string m_batchError;
+
+    RedisPipelineFlushPolicy m_flushPolicy;
+    size_t m_bufferedBytes;
+    std::chrono::time_point<std::chrono::steady_clock> m_firstBuffered;
+
     void mayflush()
     {
-        if (m_remaining >= COMMAND_MAX)
+        if (m_remaining == 0)
+            return;
+
+        if ((m_flushPolicy.maxCommands && m_remaining >= m_flushPolicy.maxCommands) ||
+            (m_flushPolicy.maxBytes && m_bufferedBytes >= m_flushPolicy.maxBytes))
+        {
             flush();
+            return;
+        }
+        flushIfExpired();
+    }
+
+    void flushAsync()
+    {
+        if (!m_shaPub.empty())
+        {
+            RedisCommand cmd;
+            cmd.format(
+                "EVALSHA %s 0",
+                m_shaPub.c_str());
+            if (cmd.appendTo(m_db->getContext()) != REDIS_OK)
+            {
+                throw std::bad_alloc();
+            }
+            m_expectedTypes.push(REDIS_REPLY_NIL);
+            m_remaining++;
+        }
+
+        while (!m_expectedTypes.empty())
+        {
+            m_asyncExpectedTypes.push(m_expectedTypes.front());
+            m_expectedTypes.pop();
+        }
+        m_inflightBatches.push(m_remaining);
+        m_inflight += m_remaining;
+        m_remaining = 0;
+
+        // The rest is written by readAsyncReplies() once the socket is writable
+        NonBlocking nonBlocking(m_db->getContext());
+        writeAsync();
+    }
+
+    /* Switch the blocking hiredis context to non blocking I/O for a scope */
+    class NonBlocking
+    {
+    public:
+        NonBlocking(redisContext *ctx) : m_ctx(ctx)
+        {
+            m_fileFlags = fcntl(ctx->fd, F_GETFL);
+            if (m_fileFlags < 0 || fcntl(ctx->fd, F_SETFL, m_fileFlags | O_NONBLOCK) < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "fcntl failed in RedisPipeline");
+            }
+            m_contextFlags = ctx->flags;
+            ctx->flags &= ~REDIS_BLOCK;
+        }
+
+        ~NonBlocking()
+        {
+            m_ctx->flags = m_contextFlags;
+            fcntl(m_ctx->fd, F_SETFL, m_fileFlags);
+        }
+
+    private:
+        redisContext *m_ctx;
+        int m_fileFlags;
+        int m_contextFlags;
+    };
+
+    void writeAsync()
+    {
+        redisContext *ctx = m_db->getContext();
+        int done = 0;
+        do
+        {
+            errno = 0;
+            if (redisBufferWrite(ctx, &done) != REDIS_OK)
+            {
+                throw RedisError("Failed to redisBufferWrite in RedisPipeline::writeAsync", ctx);
+            }
+            if (!done && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // the socket is full
+                break;
+            }
+        } while (!done);
+
+        setPendingWrite(!done);
+    }
+
+    void setPendingWrite(bool pending)
+    {
+        if (pending == m_pendingWrite)
+        {
+            return;
+        }
+
+        m_pendingWrite = pending;
+        if (m_asyncFd >= 0)
+        {
+            struct epoll_event ev = {};
+            ev.events = pending ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT) : static_cast<uint32_t>(EPOLLIN);
+            if (epoll_ctl(m_asyncFd, EPOLL_CTL_MOD, getFd(), &ev) < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "epoll_ctl failed in RedisPipeline::setPendingWrite");
+            }
+        }
+    }
+
+    void completeAsyncReply(redisReply *reply)
+    {
+        RedisReply r(reply);
+        m_inflight--;
+
+        int expectedType = m_asyncExpectedTypes.front();
+        m_asyncExpectedTypes.pop();
+        try
+        {
+            r.checkReplyType(expectedType);
+            if (expectedType == REDIS_REPLY_STATUS)
+            {
+                r.checkStatusOK();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            if (m_batchError.empty())
+            {
+                m_batchError = e.what();
+            }
+        }
+
+        if (--m_inflightBatches.front() > 0)
+        {
+            return;
+        }
+        m_inflightBatches.pop();
+
+        std::string error;
+        error.swap(m_batchError);
+        if (m_flushCallback)
+        {
+            m_flushCallback(error);
+        }
+        else if (!error.empty())
+        {
+            SWSS_LOG_ERROR("RedisPipeline async flush failed: %s, Database: %s", error.c_str(), getDbName().c_str());
+        }
     }
 };
 
+/*
+ * Drains the replies of an async RedisPipeline from a Select loop. Completion
+ * is reported through the pipeline FlushCallback, the application can ignore
+ * this object when Select returns it.
+ */
+class RedisPipelineSelectable : public Selectable
+{
+public:
+    RedisPipelineSelectable(RedisPipeline *pipeline, int pri = 0)
+        : Selectable(pri)
+        , m_pipeline(pipeline)
+    {
+    }
+
+    int getFd() override
+    {
+        return m_pipeline->getAsyncFd();
+    }
+
+    uint64_t readData() override
+    {
+        m_pipeline->readAsyncReplies();
+        return 0;
+    }
+
+private:
+    RedisPipeline *m_pipeline;
+};
+
+/*
+ * Periodically flushes a buffered pipeline whose oldest command passed the
+ * maxAgeMs of its flush policy, so that a trickle of commands does not stay
+ * buffered until the next explicit flush. The application can ignore this
+ * object when Select returns it.
+ */
+class RedisPipelineFlushTimer : public SelectableTimer
+{
+public:
+    RedisPipelineFlushTimer(RedisPipeline *pipeline, const timespec& interval, int pri = 50)
+        : SelectableTimer(interval, pri)
+        , m_pipeline(pipeline)
+    {
+    }
+
+    uint64_t readData() override
+    {
+        uint64_t cnt = SelectableTimer::readData();
+        m_pipeline->flushIfExpired();
+        return cnt;
+    }
+
+private:
+    RedisPipeline *m_pipeline;
+};
+
 }
@@ -1,6 +1,8 @@
 #include "common/selectable.h"
 #include "common/logger.h"
 #include "common/select.h"
+#include "common/table.h"
+#include "common/iouringpoller.h"
 #include <algorithm>
 #include <stdio.h>
 #include <sys/time.h>
@@ -9,14 +11,29 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdexcept>
+#include <system_error>
 
 
 using namespace std;
 
 namespace swss {
 
-Select::Select()
+Select::Select(Backend backend)
+    : m_epoll_fd(-1)
 {
+    if (backend == Backend::IO_URING)
+    {
+        try
+        {
+            m_uring.reset(new IoUringPoller());
+            return;
+        }
+        catch (const std::system_error& ex)
+        {
+            SWSS_LOG_WARN("io_uring is not available, fall back to epoll: %s", ex.what());
+        }
+    }
+
     m_epoll_fd = ::epoll_create1(0);
     if (m_epoll_fd == -1)
     {
@@ -29,26 +46,25 @@ Select::Select()
 
 Select::~Select()
 {
-    (void)::close(m_epoll_fd);
+    if (m_epoll_fd >= 0)
+    {
+        (void)::close(m_epoll_fd);
+    }
 }
 
-void Select::addSelectable(Selectable *selectable)
+Select::Backend Select::getBackend() const
 {
-    const int fd = selectable->getFd();
+    return m_uring ? Backend::IO_URING : Backend::EPOLL;
+}
 
-    if(m_objects.find(fd) != m_objects.end())
+void Select::add_fd(int fd)
+{
+    if (m_uring)
     {
-        SWSS_LOG_WARN("Selectable is already added to the list, ignoring.");
+        m_uring->add(fd);
         return;
     }
 
-    m_objects[fd] = selectable;
-
-    if (selectable->initializedWithData())
-    {
-        m_ready.insert(selectable);
-    }
-
     struct epoll_event ev = {
         .events = EPOLLIN,
         .data = { .fd = fd, },
@@ -64,12 +80,13 @@ void Select::addSelectable(Selectable *selectable)
     }
 }
 
-void Select::removeSelectable(Selectable *selectable)
+void Select::del_fd(int fd)
 {
-    const int fd = selectable->getFd();
-
-    m_objects.erase(fd);
-    m_ready.erase(selectable);
+    if (m_uring)
+    {
+        m_uring->remove(fd);
+        return;
+    }
 
     int res = ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
     if (res == -1)
@@ -81,6 +98,58 @@ void Select::removeSelectable(Selectable *selectable)
     }
 }
 
+void Select::mod_fd(int fd, uint32_t events)
+{
+    struct epoll_event ev = {
+        .events = events,
+        .data = { .fd = fd, },
+    };
+
+    int res = ::epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    if (res == -1)
+    {
+        std::string error = std::string("Select::mod_fd:epoll_ctl: error=("
+                          + std::to_string(errno) + "}:"
+                          + strerror(errno));
+        throw std::runtime_error(error);
+    }
+}
+
+void Select::addSelectable(Selectable *selectable)
+{
+    const int fd = selectable->getFd();
+
+    if(m_objects.find(fd) != m_objects.end())
+    {
+        SWSS_LOG_WARN("Selectable is already added to the list, ignoring.");
+        return;
+    }
+
+    m_objects[fd] = selectable;
+    m_events.resize(m_objects.size());
+
+    if (selectable->initializedWithData())
+    {
+        insert_ready(selectable);
+    }
+
+    add_fd(fd);
+}
+
+void Select::removeSelectable(Selectable *selectable)
+{
+    const int fd = selectable->getFd();
+
+    m_objects.erase(fd);
+    m_paused.erase(fd);
+    m_ready.erase(selectable);
+    m_exhausted.erase(selectable);
+    m_dispatched.erase(std::remove(m_dispatched.begin(), m_dispatched.end(), selectable), m_dispatched.end());
+    m_stats.erase(selectable);
+
+    del_fd(fd);
+}
+
 void Select::addSelectables(vector<Selectable *> selectables)
 {
     for(auto it : selectables)
@@ -89,15 +158,66 @@ void Select::addSelectables(vector<Selectable *> selectables)
     }
 }
 
-int Select::poll_descriptors(Selectable **c, unsigned int timeout, bool interrupt_on_signal = false)
+void Select::pauseSelectable(Selectable *selectable)
+{
+    const int fd = selectable->getFd();
+    if (m_objects.find(fd) == m_objects.end() || !m_paused.insert(fd).second)
+    {
+        return;
+    }
+
+    m_ready.erase(selectable);
+    m_exhausted.erase(selectable);
+    m_dispatched.erase(std::remove(m_dispatched.begin(), m_dispatched.end(), selectable), m_dispatched.end());
+
+    if (m_uring)
+    {
+        m_uring->remove(fd);
+        return;
+    }
+
+    // EPOLLHUP and EPOLLERR can't be masked, one shot reports them at most
+    // once until the fd is resumed
+    mod_fd(fd, EPOLLONESHOT);
+}
+
+void Select::resumeSelectable(Selectable *selectable)
+{
+    const int fd = selectable->getFd();
+    if (m_paused.erase(fd) == 0)
+    {
+        return;
+    }
+
+    if (m_uring)
+    {
+        m_uring->add(fd);
+        return;
+    }
+
+    mod_fd(fd, EPOLLIN);
+}
+
+bool Select::isRequeued(Selectable *selectable) const
+{
+    return m_ready.count(selectable) || m_exhausted.count(selectable);
+}
+
+int Select::poll_descriptors(unsigned int timeout, bool interrupt_on_signal = false)
 {
     int sz_selectables = static_cast<int>(m_objects.size());
-    std::vector<struct epoll_event> events(sz_selectables);
     int ret;
 
     while(true)
     {
-        ret = ::epoll_wait(m_epoll_fd, events.data(), sz_selectables, timeout);
+        if (m_uring)
+        {
+            ret = m_uring->wait(m_ready_fds, static_cast<int>(timeout));
+        }
+        else
+        {
+            ret = ::epoll_wait(m_epoll_fd, m_events.data(), sz_selectables, timeout);
+        }
         // on signal interrupt check if we need to return
         if (ret == -1 && errno == EINTR)
         {
@@ -120,8 +240,14 @@ int Select::poll_descriptors(Selectable **c, unsigned int timeout, bool interrup
 
     for (int i = 0; i < ret; ++i)
     {
-        int fd = events[i].data.fd;
+        int fd = m_uring ? m_ready_fds[i] : m_events[i].data.fd;
+        if (m_paused.count(fd))
+        {
+            continue;
+        }
+
         Selectable* sel = m_objects[fd];
+        auto start = m_stats_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
         try
         {
             sel->readData();
@@ -131,11 +257,134 @@ int Select::poll_descriptors(Selectable **c, unsigned int timeout, bool interrup
             SWSS_LOG_ERROR("readData error: %s", ex.what());
             return Select::ERROR;
         }
+
+        if (m_stats_enabled)
+        {
+            auto &stats = m_stats[sel].stats;
+            stats.readDataCalls++;
+            stats.readDataTimeNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                        std::chrono::steady_clock::now() - start).count());
+        }
+        insert_ready(sel);
+    }
+
+    return Select::OBJECT;
+}
+
+void Select::insert_ready(Selectable *sel)
+{
+    if (m_stats_enabled)
+    {
+        // the latency counts from the first readiness since the last dispatch
+        auto &entry = m_stats[sel];
+        if (!entry.ready)
+        {
+            entry.ready = true;
+            entry.readyTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    if (sel->isBudgetExhausted())
+    {
+        m_exhausted.insert(sel);
+    }
+    else
+    {
+        m_ready.insert(sel);
+    }
+}
+
+void Select::charge_dispatched()
+{
+    if (m_dispatched.empty())
+    {
+        return;
+    }
+
+    auto share = (std::chrono::steady_clock::now() - m_dispatch_time) / m_dispatched.size();
+    for (auto sel : m_dispatched)
+    {
+        if (m_stats_enabled)
+        {
+            m_stats[sel].stats.handlerTimeNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(share).count());
+        }
+
+        if (sel->m_time_budget.count() == 0)
+        {
+            continue;
+        }
+
+        sel->m_time_used += std::chrono::duration_cast<std::chrono::nanoseconds>(share);
+        if (sel->isBudgetExhausted() && m_ready.erase(sel))
+        {
+            // serve the others first
+            m_exhausted.insert(sel);
+        }
+    }
+    m_dispatched.clear();
+}
+
+void Select::start_round()
+{
+    for (auto &object : m_objects)
+    {
+        object.second->m_time_used = std::chrono::nanoseconds(0);
+    }
+
+    for (auto sel : m_exhausted)
+    {
         m_ready.insert(sel);
     }
+    m_exhausted.clear();
+}
 
-    while (!m_ready.empty())
+void Select::dispatch(Selectable *sel)
+{
+    bool cached = sel->hasCachedData();
+    if (m_stats_enabled)
     {
+        auto &entry = m_stats[sel];
+        // ready before the stats were enabled when not marked
+        uint64_t latency = entry.ready ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - entry.readyTime).count()) : 0;
+        size_t bucket = 0;
+        while (bucket < SelectableStats::LATENCY_BUCKETS - 1 && latency >= (1000ULL << bucket))
+        {
+            bucket++;
+        }
+
+        entry.ready = false;
+        entry.stats.dispatches++;
+        entry.stats.requeues += cached ? 1 : 0;
+        entry.stats.totalLatencyNs += latency;
+        entry.stats.maxLatencyNs = std::max(entry.stats.maxLatencyNs, latency);
+        entry.stats.latencyHistogram[bucket]++;
+    }
+
+    if (cached)
+    {
+        // reinsert Selectable back to the m_ready set, when there're more messages in the cache
+        insert_ready(sel);
+    }
+
+    sel->updateAfterRead();
+    m_dispatched.push_back(sel);
+}
+
+Selectable *Select::next_ready()
+{
+    while (true)
+    {
+        if (m_ready.empty())
+        {
+            // Every Selectable within its budget is served, start a new round
+            if (m_exhausted.empty())
+            {
+                return nullptr;
+            }
+            start_round();
+        }
+
         auto sel = *m_ready.begin();
 
         m_ready.erase(sel);
@@ -148,47 +397,164 @@ int Select::poll_descriptors(Selectable **c, unsigned int timeout, bool interrup
             continue;
         }
 
-        *c = sel;
+        dispatch(sel);
+        return sel;
+    }
+}
+
+int Select::select(Selectable **c, int timeout, bool interrupt_on_signal)
+{
+    SWSS_LOG_ENTER();
+
+    int ret;
+
+    *c = NULL;
+    charge_dispatched();
+
+    /* check if we have some data */
+    ret = poll_descriptors(0);
+    if (ret == Select::OBJECT)
+    {
+        *c = next_ready();
 
-        if (sel->hasCachedData())
+        /* wait for data unless desired timeout was 0 */
+        if (*c == NULL && timeout != 0)
         {
-            // reinsert Selectable back to the m_ready set, when there're more messages in the cache
-            m_ready.insert(sel);
+            ret = poll_descriptors(timeout, interrupt_on_signal);
+            if (ret == Select::OBJECT)
+            {
+                *c = next_ready();
+            }
         }
+    }
 
-        sel->updateAfterRead();
-
-        return Select::OBJECT;
+    if (ret != Select::OBJECT)
+    {
+        return ret;
     }
 
-    return Select::TIMEOUT;
+    m_dispatch_time = std::chrono::steady_clock::now();
+    return *c ? Select::OBJECT : Select::TIMEOUT;
 }
 
-int Select::select(Selectable **c, int timeout, bool interrupt_on_signal)
+int Select::selectMany(std::vector<Selectable *> &selectables, int timeout, bool interrupt_on_signal)
 {
     SWSS_LOG_ENTER();
 
     int ret;
 
-    *c = NULL;
+    selectables.clear();
+    charge_dispatched();
 
     /* check if we have some data */
-    ret = poll_descriptors(c, 0);
+    ret = poll_descriptors(0);
+    if (ret == Select::OBJECT)
+    {
+        collect_ready(selectables);
+
+        /* wait for data unless desired timeout was 0 */
+        if (selectables.empty() && timeout != 0)
+        {
+            ret = poll_descriptors(timeout, interrupt_on_signal);
+            if (ret == Select::OBJECT)
+            {
+                collect_ready(selectables);
+            }
+        }
+    }
 
-    /* return if we have data, we have an error or desired timeout was 0 */
-    if (ret != Select::TIMEOUT || timeout == 0)
+    if (ret != Select::OBJECT)
+    {
         return ret;
+    }
 
-    /* wait for data */
-    ret = poll_descriptors(c, timeout, interrupt_on_signal);
+    m_dispatch_time = std::chrono::steady_clock::now();
+    return selectables.empty() ? Select::TIMEOUT : Select::OBJECT;
+}
+
+void Select::collect_ready(std::vector<Selectable *> &selectables)
+{
+    while (selectables.empty())
+    {
+        if (m_ready.empty())
+        {
+            // Every Selectable within its budget is served, start a new round
+            if (m_exhausted.empty())
+            {
+                return;
+            }
+            start_round();
+        }
 
-    return ret;
+        // Those with more cached data go back to m_ready for the next call
+        selectables.assign(m_ready.begin(), m_ready.end());
+        m_ready.clear();
+        size_t count = 0;
+        for (auto sel : selectables)
+        {
+            sel->updateLastUsedTime();
+            if (!sel->hasData())
+            {
+                continue;
+            }
 
+            dispatch(sel);
+            selectables[count++] = sel;
+        }
+        selectables.resize(count);
+    }
 }
 
 bool Select::isQueueEmpty()
 {
-    return m_ready.empty();
+    return m_ready.empty() && m_exhausted.empty();
+}
+
+void Select::enableStats(bool enable)
+{
+    m_stats_enabled = enable;
+    if (!enable)
+    {
+        m_stats.clear();
+    }
+}
+
+SelectableStats Select::getStats(Selectable *selectable) const
+{
+    auto it = m_stats.find(selectable);
+    return it == m_stats.end() ? SelectableStats() : it->second.stats;
+}
+
+void Select::writeStats(Table &table) const
+{
+    for (auto &object : m_objects)
+    {
+        auto it = m_stats.find(object.second);
+        if (it == m_stats.end())
+        {
+            continue;
+        }
+
+        auto &stats = it->second.stats;
+        std::string histogram;
+        for (size_t i = 0; i < SelectableStats::LATENCY_BUCKETS; i++)
+        {
+            histogram += (i ? "," : "") + std::to_string(stats.latencyHistogram[i]);
+        }
+
+        std::vector<FieldValueTuple> fvs = {
+            { "priority", std::to_string(object.second->getPri()) },
+            { "dispatches", std::to_string(stats.dispatches) },
+            { "requeues", std::to_string(stats.requeues) },
+            { "read_data_calls", std::to_string(stats.readDataCalls) },
+            { "read_data_time_us", std::to_string(stats.readDataTimeNs / 1000) },
+            { "handler_time_us", std::to_string(stats.handlerTimeNs / 1000) },
+            { "latency_avg_us", std::to_string(stats.dispatches ? stats.totalLatencyNs / stats.dispatches / 1000 : 0) },
+            { "latency_max_us", std::to_string(stats.maxLatencyNs / 1000) },
+            { "latency_histogram_us_log2", histogram },
+        };
+        table.set("fd" + std::to_string(object.first), fvs);
+    }
 }
 
 std::string Select::resultToString(int result)
@@ -5,18 +5,56 @@
 #include <vector>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
+#include <chrono>
+#include <memory>
+#include <sys/epoll.h>
 #include <hiredis/hiredis.h>
 #include "selectable.h"
 
 namespace swss {
 
+class Table;
+class IoUringPoller;
+
+/* Event loop counters of a Selectable, see Select::enableStats() */
+struct SelectableStats
+{
+    static const size_t LATENCY_BUCKETS = 20;
+
+    uint64_t dispatches = 0;
+    uint64_t requeues = 0;          // dispatches leaving cached data for the next one
+    uint64_t readDataCalls = 0;
+    uint64_t readDataTimeNs = 0;
+    uint64_t handlerTimeNs = 0;     // time the application took until its next select
+    uint64_t totalLatencyNs = 0;    // readiness to dispatch
+    uint64_t maxLatencyNs = 0;
+
+    // Readiness to dispatch latency, bucket i counts the latencies under
+    // 2^i microseconds, the last bucket counts the longer ones
+    uint64_t latencyHistogram[LATENCY_BUCKETS] = {};
+};
+
 class Select
 {
 public:
-    Select();
+    /* How Select waits for its descriptors */
+    enum class Backend
+    {
+        EPOLL,
+        // io_uring poll requests, submitted with the wait in one system
+        // call, needs Linux 5.11
+        IO_URING,
+    };
+
+    /* Fall back to epoll when the kernel doesn't support io_uring */
+    Select(Backend backend = Backend::EPOLL);
     ~Select();
 
+    /* Backend in use, may differ from the one asked for */
+    Backend getBackend() const;
+
     /* Add object for select */
     void addSelectable(Selectable *selectable);
 
@@ -26,6 +64,20 @@ public:
     /* Add multiple objects for select */
     void addSelectables(std::vector<Selectable *> selectables);
 
+    /*
+     * Stop watching an added Selectable until it is resumed, e.g. while
+     * another thread handles its data. It is neither read nor returned
+     * meanwhile, unlike removing it its stats are kept. Its queued
+     * readiness is dropped, see isRequeued().
+     */
+    void pauseSelectable(Selectable *selectable);
+
+    /* Watch a paused Selectable again */
+    void resumeSelectable(Selectable *selectable);
+
+    /* Whether the last select() queued the Selectable again for its cached data */
+    bool isRequeued(Selectable *selectable) const;
+
     enum {
         OBJECT = 0,
         ERROR = 1,
@@ -34,8 +86,31 @@ public:
     };
 
     int select(Selectable **c, int timeout = -1, bool interrupt_on_signal = false);
+
+    /*
+     * Same as select(), return every ready Selectable at once, highest
+     * priority first. Each Selectable is returned once per call, those with
+     * more cached data are returned again by the next call.
+     * The time until the next call is charged to the time budgets of the
+     * returned Selectables in equal shares.
+     */
+    int selectMany(std::vector<Selectable *> &selectables, int timeout = -1, bool interrupt_on_signal = false);
+
     bool isQueueEmpty();
 
+    /* Collect SelectableStats for every Selectable, disabling drops them */
+    void enableStats(bool enable);
+
+    /* Stats of a Selectable, all zero if it is unknown or the stats are disabled */
+    SelectableStats getStats(Selectable *selectable) const;
+
+    /*
+     * Write the stats to table, e.g. of STATE_DB, one entry per fd, so
+     * the hot spots of an event loop can be found in production. The
+     * application calls it on demand, e.g. when a signal was received.
+     */
+    void writeStats(Table &table) const;
+
     /**
      * @brief Result to string.
      *
@@ -66,11 +141,44 @@ private:
         }
     };
 
-    int poll_descriptors(Selectable **c, unsigned int timeout, bool interrupt_on_signal);
+    typedef std::set<Selectable *, Select::cmp> ReadySet;
+
+    int poll_descriptors(unsigned int timeout, bool interrupt_on_signal);
+    Selectable *next_ready();
+    void collect_ready(std::vector<Selectable *> &selectables);
+    void dispatch(Selectable *sel);
+    void insert_ready(Selectable *sel);
+    void charge_dispatched();
+    void start_round();
+
+    struct StatsEntry
+    {
+        SelectableStats stats;
+        bool ready = false;
+        std::chrono::time_point<std::chrono::steady_clock> readyTime;
+    };
+
+    void add_fd(int fd);
+    void del_fd(int fd);
+    void mod_fd(int fd, uint32_t events);
 
+    // -1 when io_uring is used
     int m_epoll_fd;
+    std::unique_ptr<IoUringPoller> m_uring;
+    // reused by every io_uring wait
+    std::vector<int> m_ready_fds;
     std::unordered_map<int, Selectable *> m_objects;
-    std::set<Selectable *, Select::cmp> m_ready;
+    std::unordered_set<int> m_paused;
+    ReadySet m_ready;
+    // ready Selectables that spent their time budget in this round
+    ReadySet m_exhausted;
+    // reused by every epoll_wait()
+    std::vector<struct epoll_event> m_events;
+    // returned by the last call, charged with the time until the next call
+    std::vector<Selectable *> m_dispatched;
+    std::chrono::time_point<std::chrono::steady_clock> m_dispatch_time;
+    bool m_stats_enabled = false;
+    std::unordered_map<Selectable *, StatsEntry> m_stats;
 };
 
 }
@@ -58,6 +58,22 @@ public:
         return m_priority;
     }
 
+    /*
+     * Time this Selectable may take per scheduling round of Select, 0 for
+     * no limit. Once the application spent the budget on it, Select
+     * serves the other ready Selectables first, whatever their priority,
+     * and starts a new round when they are done.
+     */
+    void setTimeBudget(std::chrono::microseconds budget)
+    {
+        m_time_budget = budget;
+    }
+
+    std::chrono::microseconds getTimeBudget() const
+    {
+        return m_time_budget;
+    }
+
 private:
 
     friend class Select;
@@ -75,9 +91,16 @@ private:
     }
 
 
+    bool isBudgetExhausted() const
+    {
+        return m_time_budget.count() > 0 && m_time_used >= m_time_budget;
+    }
+
     int m_priority; // defines priority of Selectable inside Select
                     // higher value is higher priority
     std::chrono::time_point<std::chrono::steady_clock> m_last_used_time;
+    std::chrono::microseconds m_time_budget{0};
+    std::chrono::nanoseconds m_time_used{0};    // in the current round of Select
 };
 
 }
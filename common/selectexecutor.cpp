@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <limits>
+#include "logger.h"
+#include "selectexecutor.h"
+
+using namespace std;
+
+namespace swss {
+
+SelectExecutor::SelectExecutor(size_t workers, Select::Backend backend)
+    : m_select(backend)
+    , m_wakeup(numeric_limits<int>::max())
+    , m_running(false)
+    , m_stopping(false)
+    , m_nextWorker(0)
+    , m_sharedCount(0)
+{
+    workers = max(workers, static_cast<size_t>(1));
+    for (size_t i = 0; i < workers; i++)
+    {
+        m_workers.emplace_back(new Worker());
+    }
+
+    m_select.addSelectable(&m_wakeup);
+}
+
+SelectExecutor::~SelectExecutor()
+{
+    stop();
+}
+
+void SelectExecutor::addSelectable(Selectable *selectable, Handler handler, int group, int worker)
+{
+    if (m_running)
+    {
+        SWSS_LOG_THROW("Selectable can't be added to a running executor");
+    }
+
+    if (worker != ANY_WORKER && (worker < 0 || static_cast<size_t>(worker) >= m_workers.size()))
+    {
+        SWSS_LOG_THROW("invalid worker %d of %zu workers", worker, m_workers.size());
+    }
+
+    if (m_entries.find(selectable) != m_entries.end())
+    {
+        SWSS_LOG_WARN("Selectable is already added to the executor, ignoring.");
+        return;
+    }
+
+    m_entries[selectable] = { handler, group, worker };
+    m_select.addSelectable(selectable);
+}
+
+void SelectExecutor::removeSelectable(Selectable *selectable)
+{
+    if (m_running)
+    {
+        SWSS_LOG_THROW("Selectable can't be removed from a running executor");
+    }
+
+    auto it = m_entries.find(selectable);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+
+    m_select.removeSelectable(selectable);
+    m_deferred.erase(remove_if(m_deferred.begin(), m_deferred.end(),
+                               [selectable](const Task &task) { return task.selectable == selectable; }),
+                     m_deferred.end());
+    m_entries.erase(it);
+}
+
+void SelectExecutor::start()
+{
+    if (m_running)
+    {
+        return;
+    }
+
+    m_stopping = false;
+    m_running = true;
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        vector<Task> deferred;
+        deferred.swap(m_deferred);
+        for (auto &task : deferred)
+        {
+            submit(task);
+        }
+    }
+
+    for (size_t i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i]->thread = thread(&SelectExecutor::workerLoop, this, i);
+    }
+    m_pollThread = thread(&SelectExecutor::pollLoop, this);
+}
+
+void SelectExecutor::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_stopping = true;
+    m_wakeup.notify();
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+    }
+    m_cv.notify_all();
+
+    m_pollThread.join();
+    for (auto &worker : m_workers)
+    {
+        worker->thread.join();
+    }
+
+    // Keep what isn't handled yet for the next start, groups in order
+    lock_guard<mutex> lock(m_mutex);
+    for (auto &worker : m_workers)
+    {
+        m_deferred.insert(m_deferred.end(), worker->pinned.begin(), worker->pinned.end());
+        m_deferred.insert(m_deferred.end(), worker->shared.begin(), worker->shared.end());
+        worker->pinned.clear();
+        worker->shared.clear();
+        worker->pinnedCount = 0;
+    }
+    m_sharedCount = 0;
+
+    for (auto &group : m_groups)
+    {
+        m_deferred.insert(m_deferred.end(), group.second.pending.begin(), group.second.pending.end());
+        group.second.pending.clear();
+        group.second.running = false;
+    }
+
+    for (auto selectable : m_handled)
+    {
+        m_select.resumeSelectable(selectable);
+    }
+    m_handled.clear();
+
+    m_running = false;
+}
+
+void SelectExecutor::pollLoop()
+{
+    while (!m_stopping)
+    {
+        Selectable *sel;
+        int ret = m_select.select(&sel);
+        if (ret == Select::ERROR)
+        {
+            SWSS_LOG_ERROR("select failed, errno: %d", errno);
+            continue;
+        }
+
+        if (ret != Select::OBJECT)
+        {
+            continue;
+        }
+
+        if (sel == &m_wakeup)
+        {
+            vector<Selectable *> handled;
+            {
+                lock_guard<mutex> lock(m_mutex);
+                handled.swap(m_handled);
+            }
+
+            for (auto selectable : handled)
+            {
+                m_select.resumeSelectable(selectable);
+            }
+            continue;
+        }
+
+        // The task hands the cached data over, no readData() while the
+        // handler runs
+        bool cached = m_select.isRequeued(sel);
+        m_select.pauseSelectable(sel);
+
+        lock_guard<mutex> lock(m_mutex);
+        submit({ sel, cached });
+    }
+}
+
+void SelectExecutor::workerLoop(size_t id)
+{
+    Task task;
+    while (nextTask(id, task))
+    {
+        // m_entries only changes while the executor is stopped
+        auto &handler = m_entries[task.selectable].handler;
+        try
+        {
+            handler(task.selectable);
+        }
+        catch (const exception &e)
+        {
+            SWSS_LOG_ERROR("handler of fd %d failed: %s", task.selectable->getFd(), e.what());
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        complete(task);
+    }
+}
+
+bool SelectExecutor::popTask(Worker &worker, deque<Task> &queue, atomic<size_t> &count, Task &task)
+{
+    lock_guard<mutex> lock(worker.mutex);
+    if (queue.empty())
+    {
+        return false;
+    }
+
+    task = queue.front();
+    queue.pop_front();
+    count--;
+    return true;
+}
+
+bool SelectExecutor::nextTask(size_t id, Task &task)
+{
+    auto &self = *m_workers[id];
+    while (true)
+    {
+        if (popTask(self, self.pinned, self.pinnedCount, task) || popTask(self, self.shared, m_sharedCount, task))
+        {
+            return true;
+        }
+
+        // Steal the oldest task of another worker
+        for (size_t i = 1; i < m_workers.size(); i++)
+        {
+            auto &other = *m_workers[(id + i) % m_workers.size()];
+            if (popTask(other, other.shared, m_sharedCount, task))
+            {
+                return true;
+            }
+        }
+
+        unique_lock<mutex> lock(m_sleepMutex);
+        m_cv.wait(lock, [&] { return m_stopping || self.pinnedCount > 0 || m_sharedCount > 0; });
+        if (m_stopping)
+        {
+            return false;
+        }
+    }
+}
+
+void SelectExecutor::submit(const Task &task)
+{
+    if (m_stopping)
+    {
+        m_deferred.push_back(task);
+        return;
+    }
+
+    auto &entry = m_entries[task.selectable];
+    if (entry.group != NO_GROUP)
+    {
+        auto &group = m_groups[entry.group];
+        if (group.running)
+        {
+            group.pending.push_back(task);
+            return;
+        }
+        group.running = true;
+    }
+
+    enqueue(task);
+}
+
+void SelectExecutor::enqueue(const Task &task)
+{
+    int pinned = m_entries[task.selectable].worker;
+    if (pinned != ANY_WORKER)
+    {
+        auto &worker = *m_workers[static_cast<size_t>(pinned)];
+        lock_guard<mutex> lock(worker.mutex);
+        worker.pinned.push_back(task);
+        worker.pinnedCount++;
+    }
+    else
+    {
+        auto &worker = *m_workers[m_nextWorker++ % m_workers.size()];
+        lock_guard<mutex> lock(worker.mutex);
+        worker.shared.push_back(task);
+        m_sharedCount++;
+    }
+
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+    }
+    if (pinned != ANY_WORKER)
+    {
+        // only the pinned worker may take it
+        m_cv.notify_all();
+    }
+    else
+    {
+        m_cv.notify_one();
+    }
+}
+
+void SelectExecutor::complete(const Task &task)
+{
+    auto sel = task.selectable;
+    auto &entry = m_entries[sel];
+    if (entry.group != NO_GROUP)
+    {
+        auto &group = m_groups[entry.group];
+        group.running = false;
+        if (!group.pending.empty())
+        {
+            auto next = group.pending.front();
+            group.pending.pop_front();
+            submit(next);
+        }
+    }
+
+    if (task.cached && sel->hasData())
+    {
+        // The next read from the cache, like Select dispatches it
+        bool cached = sel->hasCachedData();
+        sel->updateAfterRead();
+        submit({ sel, cached });
+        return;
+    }
+
+    if (m_handled.empty())
+    {
+        m_wakeup.notify();
+    }
+    m_handled.push_back(sel);
+}
+
+}
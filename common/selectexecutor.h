@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include "select.h"
+#include "selectableevent.h"
+
+namespace swss {
+
+/*
+ * Event loop of Select dispatching the ready Selectables to a pool of
+ * worker threads, so the consumers of independent tables run in parallel.
+ *
+ * One thread runs the Select. A ready Selectable is paused in it and
+ * its handler is run by a worker, so readData() and the handler of a
+ * Selectable never run at the same time, and a Selectable is never handled
+ * by two workers at once. It is resumed when its cached data is handled.
+ * Each worker has its own queue and idle workers steal from the others.
+ *
+ * Handlers of the Selectables of a serialization group run one at a time,
+ * in the order the Selectables got ready, e.g. for tables depending on each
+ * other. A Selectable with an affinity is always handled by that worker.
+ */
+class SelectExecutor
+{
+public:
+    typedef std::function<void(Selectable *)> Handler;
+
+    static const int NO_GROUP = -1;
+    static const int ANY_WORKER = -1;
+
+    SelectExecutor(size_t workers = std::thread::hardware_concurrency(), Select::Backend backend = Select::Backend::EPOLL);
+
+    /* Stop the threads */
+    ~SelectExecutor();
+
+    SelectExecutor(const SelectExecutor&) = delete;
+    SelectExecutor& operator=(const SelectExecutor&) = delete;
+
+    /*
+     * Run handler for every read of selectable, like the application of a
+     * Select after select() returned it. Only while stopped.
+     */
+    void addSelectable(Selectable *selectable, Handler handler, int group = NO_GROUP, int worker = ANY_WORKER);
+
+    /* Only while stopped */
+    void removeSelectable(Selectable *selectable);
+
+    void start();
+
+    /*
+     * Wait for the running handlers and stop the threads. The reads not
+     * handled yet are handled after the next start().
+     */
+    void stop();
+
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+private:
+    struct Task
+    {
+        Selectable *selectable;
+        // another read is in the cache
+        bool cached;
+    };
+
+    struct Entry
+    {
+        Handler handler;
+        int group;
+        int worker;
+    };
+
+    struct Group
+    {
+        bool running = false;
+        std::deque<Task> pending;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        // tasks of the Selectables with an affinity to the worker
+        std::deque<Task> pinned;
+        // tasks the other workers may steal
+        std::deque<Task> shared;
+        std::atomic<size_t> pinnedCount{0};
+        std::thread thread;
+    };
+
+    void pollLoop();
+    void workerLoop(size_t id);
+    bool nextTask(size_t id, Task &task);
+    bool popTask(Worker &worker, std::deque<Task> &queue, std::atomic<size_t> &count, Task &task);
+
+    // m_mutex must be held by the following
+    void submit(const Task &task);
+    void enqueue(const Task &task);
+    void complete(const Task &task);
+
+    Select m_select;
+    // wakes up the Select to resume the handled Selectables
+    SelectableEvent m_wakeup;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::thread m_pollThread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+
+    // guards everything below
+    std::mutex m_mutex;
+    std::unordered_map<Selectable *, Entry> m_entries;
+    std::unordered_map<int, Group> m_groups;
+    // handled, to resume in the Select
+    std::vector<Selectable *> m_handled;
+    // not handled when the executor stopped
+    std::vector<Task> m_deferred;
+    size_t m_nextWorker;
+
+    // idle workers sleep on m_cv
+    std::mutex m_sleepMutex;
+    std::condition_variable m_cv;
+    std::atomic<size_t> m_sharedCount;
+};
+
+}
@@ -1,16 +1,15 @@
 #include <hiredis/hiredis.h>
 #include <system_error>
+#include <cstring>
 
 #include "common/table.h"
 #include "common/logger.h"
 #include "common/redisreply.h"
 #include "common/rediscommand.h"
 #include "common/redisapi.h"
-#include <nlohmann/json.hpp>
 
 using namespace std;
 using namespace swss;
-using json = nlohmann::json;
 
 // NOTE: Vertical bar ('|') is the new standard for table name separator
 // moving forward. We plan to eventually deprecate the colon separator
@@ -43,6 +42,7 @@ Table::Table(RedisPipeline *pipeline, const string &tableName, bool buffered)
     , m_buffered(buffered)
     , m_pipeowned(false)
     , m_pipe(pipeline)
+    , m_dumpChunkSize(0)
 {
 }
 
@@ -69,7 +69,56 @@ bool Table::get(const string &key, vector<FieldValueTuple> &values)
     RedisCommand hgetall_key;
     hgetall_key.format("HGETALL %s", getKeyName(key).c_str());
     RedisReply r = m_pipe->push(hgetall_key, REDIS_REPLY_ARRAY);
-    redisReply *reply = r.getContext();
+    return parseHGetAllReply(r.getContext(), values);
+}
+
+bool Table::hget(const string &key, const std::string &field,  std::string &value)
+{
+    RedisCommand hget_entry;
+    hget_entry.format("HGET %s %s", getKeyName(key).c_str(), field.c_str());
+    RedisReply r = m_pipe->push(hget_entry);
+    return parseHGetReply(r.getContext(), value);
+}
+
+void Table::get(const vector<string> &keys, vector<pair<bool, vector<FieldValueTuple>>> &out)
+{
+    vector<RedisCommand> cmds(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        cmds[i].format("HGETALL %s", getKeyName(keys[i]).c_str());
+    }
+
+    auto replies = m_pipe->pushBatch(cmds);
+
+    out.clear();
+    out.resize(keys.size());
+    for (size_t i = 0; i < replies.size(); i++)
+    {
+        replies[i]->checkReplyType(REDIS_REPLY_ARRAY);
+        out[i].first = parseHGetAllReply(replies[i]->getContext(), out[i].second);
+    }
+}
+
+void Table::hget(const vector<string> &keys, const string &field, vector<pair<bool, string>> &out)
+{
+    vector<RedisCommand> cmds(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        cmds[i].format("HGET %s %s", getKeyName(keys[i]).c_str(), field.c_str());
+    }
+
+    auto replies = m_pipe->pushBatch(cmds);
+
+    out.clear();
+    out.resize(keys.size());
+    for (size_t i = 0; i < replies.size(); i++)
+    {
+        out[i].first = parseHGetReply(replies[i]->getContext(), out[i].second);
+    }
+}
+
+bool Table::parseHGetAllReply(redisReply *reply, vector<FieldValueTuple> &values)
+{
     values.clear();
 
     if (!reply->elements)
@@ -88,13 +137,8 @@ bool Table::get(const string &key, vector<FieldValueTuple> &values)
     return true;
 }
 
-bool Table::hget(const string &key, const std::string &field,  std::string &value)
+bool Table::parseHGetReply(redisReply *reply, string &value)
 {
-    RedisCommand hget_entry;
-    hget_entry.format("HGET %s %s", getKeyName(key).c_str(), field.c_str());
-    RedisReply r = m_pipe->push(hget_entry);
-    redisReply *reply = r.getContext();
-
     if (reply->type == REDIS_REPLY_NIL)
     {
         value.clear();
@@ -205,6 +249,88 @@ void TableEntryEnumerable::getContent(vector<KeyOpFieldsValuesTuple> &tuples)
     }
 }
 
+void Table::getContent(vector<KeyOpFieldsValuesTuple> &tuples)
+{
+    vector<string> keys;
+    getKeys(keys);
+
+    vector<pair<bool, vector<FieldValueTuple>>> entries;
+    get(keys, entries);
+
+    tuples.clear();
+    tuples.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        tuples.emplace_back(keys[i], "", std::move(entries[i].second));
+    }
+}
+
+uint64_t Table::scanKeys(uint64_t cursor, vector<string> &keys, uint32_t count)
+{
+    string pattern = getTableName() + getTableNameSeparator() + "*";
+    RedisCommand scan_cmd;
+    scan_cmd.format("SCAN %llu MATCH %s COUNT %u",
+                    static_cast<unsigned long long>(cursor), pattern.c_str(), count);
+    RedisReply r = m_pipe->push(scan_cmd, REDIS_REPLY_ARRAY);
+    redisReply *reply = r.getContext();
+
+    if (reply->elements != 2
+        || reply->element[0]->type != REDIS_REPLY_STRING
+        || reply->element[1]->type != REDIS_REPLY_ARRAY)
+    {
+        throw system_error(make_error_code(errc::io_error),
+                "Got unexpected reply to SCAN");
+    }
+
+    uint64_t next;
+    try
+    {
+        next = stoull(reply->element[0]->str);
+    }
+    catch (const logic_error &)
+    {
+        throw system_error(make_error_code(errc::io_error),
+                string("Invalid cursor string returned by scan: ") + reply->element[0]->str);
+    }
+
+    redisReply *found = reply->element[1];
+    keys.clear();
+    keys.reserve(found->elements);
+    for (size_t i = 0; i < found->elements; i++)
+    {
+        keys.emplace_back(found->element[i]->str + getTableName().length() + 1,
+                          found->element[i]->len - getTableName().length() - 1);
+    }
+
+    return next;
+}
+
+void Table::forEachEntry(const EntryCallback &callback, uint32_t count)
+{
+    vector<string> keys;
+    vector<pair<bool, vector<FieldValueTuple>>> entries;
+    uint64_t cursor = 0;
+
+    do
+    {
+        cursor = scanKeys(cursor, keys, count);
+        if (keys.empty())
+        {
+            continue;
+        }
+
+        get(keys, entries);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            // The key may be deleted between SCAN and HGETALL
+            if (entries[i].first)
+            {
+                callback(keys[i], entries[i].second);
+            }
+        }
+    } while (cursor != 0);
+}
+
 void Table::getKeys(vector<string> &keys)
 {
     RedisCommand keys_cmd;
@@ -220,48 +346,73 @@ void Table::getKeys(vector<string> &keys)
     }
 }
 
+void Table::setDumpChunkSize(uint32_t count)
+{
+    m_dumpChunkSize = count;
+}
+
 void Table::dump(TableDump& tableDump)
 {
     SWSS_LOG_ENTER();
 
     SWSS_LOG_TIMER("getting");
 
-    lazyLoadRedisScriptFile(m_pipe->getDBConnector(), "table_dump.lua", m_shaDump);
-    RedisCommand command;
-    command.format("EVALSHA %s 1 %s ''",
-            m_shaDump.c_str(),
-            getTableName().c_str());
-
-    RedisReply r = m_pipe->push(command, REDIS_REPLY_STRING);
+    lazyLoadRedisScriptFile(m_pipe->getDBConnector(), "table_dump_packed.lua", m_shaDump);
 
-    auto ctx = r.getContext();
+    string prefix = getTableName() + getTableNameSeparator();
+    size_t tableNameLen = getTableName().length() + 1; // + separator
+    string cursor = "0";
 
-    std::string data = ctx->str;
-
-    json j = json::parse(data);
-
-    size_t tableNameLen = getTableName().length() + 1; // + ":"
-
-    for (json::iterator it = j.begin(); it != j.end(); ++it)
+    do
     {
-        TableMap map;
+        RedisCommand command;
+        command.format("EVALSHA %s 1 %s %s %u",
+                m_shaDump.c_str(),
+                prefix.c_str(),
+                cursor.c_str(),
+                m_dumpChunkSize);
 
-        json jj = it.value();
+        RedisReply r = m_pipe->push(command, REDIS_REPLY_ARRAY);
+
+        auto ctx = r.getContext();
+        if (ctx->elements == 0 || ctx->element[0]->type != REDIS_REPLY_STRING)
+        {
+            throw system_error(make_error_code(errc::io_error),
+                    "Got unexpected reply to table dump");
+        }
+        cursor.assign(ctx->element[0]->str, ctx->element[0]->len);
 
-        for (json::iterator itt = jj.begin(); itt != jj.end(); ++itt)
+        // Entries are <key> <count> followed by count pairs of <field> <value>
+        size_t i = 1;
+        while (i < ctx->elements)
         {
-            if (itt.key() == "NULL")
+            if (i + 1 >= ctx->elements || ctx->element[i + 1]->type != REDIS_REPLY_INTEGER
+                || ctx->element[i + 1]->integer < 0
+                || static_cast<size_t>(ctx->element[i + 1]->integer) > (ctx->elements - i - 2) / 2)
             {
-                continue;
+                throw system_error(make_error_code(errc::io_error),
+                        "Got truncated reply to table dump");
             }
+            size_t count = static_cast<size_t>(ctx->element[i + 1]->integer);
 
-            map[itt.key()] = itt.value();
-        }
+            redisReply *key = ctx->element[i];
+            TableMap &map = tableDump[string(key->str + tableNameLen, key->len - tableNameLen)];
+            map.clear();
 
-        std::string key = it.key().substr(tableNameLen);
+            for (size_t j = i + 2; j < i + 2 + count * 2; j += 2)
+            {
+                redisReply *field = ctx->element[j];
+                redisReply *value = ctx->element[j + 1];
+                if (field->len == 4 && strncmp(field->str, "NULL", 4) == 0)
+                {
+                    continue;
+                }
+                map.emplace(string(field->str, field->len), string(value->str, value->len));
+            }
 
-        tableDump[key] = map;
-    }
+            i += 2 + count * 2;
+        }
+    } while (cursor != "0");
 }
 
 string Table::stripSpecialSym(const string &key)
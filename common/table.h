@@ -8,6 +8,7 @@
 #include <utility>
 #include <map>
 #include <deque>
+#include <functional>
 #include "hiredis/hiredis.h"
 #include "dbconnector.h"
 #include "redisreply.h"
@@ -180,7 +181,7 @@ public:
 
     /* Read the whole table content from the DB directly */
     /* NOTE: Not an atomic function */
-    void getContent(std::vector<KeyOpFieldsValuesTuple> &tuples);
+    virtual void getContent(std::vector<KeyOpFieldsValuesTuple> &tuples);
 };
 
 /* The default time to live for a DB entry is infinite */
@@ -232,6 +233,18 @@ public:
     virtual bool get(const std::string &key, std::vector<FieldValueTuple> &ovalues);
 
     virtual bool hget(const std::string &key, const std::string &field,  std::string &value);
+
+    /* Read several entries in one pipelined round trip */
+    /* out[i].first is false if keys[i] doesn't exist */
+    virtual void get(const std::vector<std::string> &keys,
+                     std::vector<std::pair<bool, std::vector<FieldValueTuple>>> &out);
+
+    /* Read the same field of several entries in one pipelined round trip */
+    /* out[i].first is false if keys[i] or the field doesn't exist */
+    virtual void hget(const std::vector<std::string> &keys,
+                      const std::string &field,
+                      std::vector<std::pair<bool, std::string>> &out);
+
     virtual void hset(const std::string &key,
                           const std::string &field,
                           const std::string &value,
@@ -240,12 +253,34 @@ public:
 
     void getKeys(std::vector<std::string> &keys);
 
+    /* Read the whole table with one KEYS and one pipelined batch of HGETALL */
+    void getContent(std::vector<KeyOpFieldsValuesTuple> &tuples) override;
+
+    /* Number of slots visited by every SCAN of the incremental table walks */
+    static constexpr uint32_t DEFAULT_SCAN_COUNT = 1000;
+
+    /* Fetch one batch of keys with SCAN, starting from cursor (0 to begin) */
+    /* Returns the cursor for the next call, 0 when the walk is complete */
+    /* NOTE: a key may be returned more than once if the DB changes meanwhile */
+    uint64_t scanKeys(uint64_t cursor, std::vector<std::string> &keys, uint32_t count = DEFAULT_SCAN_COUNT);
+
+    typedef std::function<void(const std::string &key, const std::vector<FieldValueTuple> &values)> EntryCallback;
+
+    /* Walk the whole table without blocking redis: keys are fetched with */
+    /* SCAN and every batch is read with one pipelined batch of HGETALL */
+    void forEachEntry(const EntryCallback &callback, uint32_t count = DEFAULT_SCAN_COUNT);
+
     void setBuffered(bool buffered);
 
     void flush();
 
+    /* Dump the whole table, atomically unless a dump chunk size is set */
     void dump(TableDump &tableDump);
 
+    /* Dump tables larger than one SCAN of count slots in several chunks, */
+    /* so that redis is never blocked for the whole table; 0 disables it */
+    void setDumpChunkSize(uint32_t count);
+
 protected:
 
     bool m_buffered;
@@ -261,6 +296,10 @@ protected:
      * */
     std::string stripSpecialSym(const std::string &key);
     std::string m_shaDump;
+    uint32_t m_dumpChunkSize;
+
+    bool parseHGetAllReply(redisReply *reply, std::vector<FieldValueTuple> &values);
+    bool parseHGetReply(redisReply *reply, std::string &value);
 };
 
 class TableName_KeyValueOpQueues {
@@ -0,0 +1,30 @@
+-- Same as table_dump.lua, but the entries are returned as one flat array
+-- instead of a cjson encoded string:
+--   <cursor> followed by <key> <count> and count pairs of <field> <value> per key
+-- With ARGV[2] == 0 the whole table is dumped atomically and the cursor is "0".
+-- Otherwise one SCAN of ARGV[2] slots is done from cursor ARGV[1], so that a
+-- large table is dumped in several chunks without blocking redis.
+local pattern = KEYS[1] .. '*'
+local count = tonumber(ARGV[2])
+local res = {}
+local keys
+
+if count == 0 then
+   keys = redis.call('KEYS', pattern)
+   table.insert(res, '0')
+else
+   local scan = redis.call('SCAN', ARGV[1], 'MATCH', pattern, 'COUNT', count)
+   keys = scan[2]
+   table.insert(res, scan[1])
+end
+
+for i = 1, #keys do
+   local flat_map = redis.call('HGETALL', keys[i])
+   table.insert(res, keys[i])
+   table.insert(res, #flat_map / 2)
+   for j = 1, #flat_map do
+      table.insert(res, flat_map[j])
+   end
+end
+
+return res
@@ -0,0 +1,8 @@
+-- Atomically replace the whole hash KEYS[1] with the field/value pairs in ARGV.
+-- An empty ARGV deletes the hash.
+redis.call('DEL', KEYS[1])
+-- unpack() is bounded by the lua C stack, split huge hashes into several HSETs
+local maxunpack = 4000
+for i = 1, #ARGV, maxunpack do
+   redis.call('HSET', KEYS[1], unpack(ARGV, i, math.min(i + maxunpack - 1, #ARGV)))
+end
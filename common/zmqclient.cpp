@@ -7,9 +7,15 @@
 #include <cmath>
 #include <exception>
 #include <system_error>
+#include <cstring>
+#include <cinttypes>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
 #include <zmq.h>
 #include "zmqclient.h"
 #include "binaryserializer.h"
+#include "zmqshm.h"
 
 using namespace std;
 
@@ -21,18 +27,32 @@ ZmqClient::ZmqClient(const std::string& endpoint)
 }
 
 ZmqClient::ZmqClient(const std::string& endpoint, const std::string& vrf)
+: m_waitTimeMs(MQ_POLL_TIMEOUT),
+  m_enableResponse(false)
 {
     initialize(endpoint, vrf);
 }
 
-ZmqClient::ZmqClient(const std::string& endpoint, uint32_t waitTimeMs)
-: m_waitTimeMs(waitTimeMs)
+ZmqClient::ZmqClient(const std::string& endpoint, uint32_t waitTimeMs, bool enableResponse)
+: m_waitTimeMs(waitTimeMs),
+  m_enableResponse(enableResponse)
 {
     initialize(endpoint);
 }
 
 ZmqClient::~ZmqClient()
 {
+    if (m_sendThread)
+    {
+        // the sender thread sends the queued operations before exiting
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_stopSendThread = true;
+        }
+        m_queueCv.notify_all();
+        m_sendThread->join();
+    }
+
     std::lock_guard<std::mutex> lock(m_socketMutex);
     if (m_socket)
     {
@@ -48,6 +68,8 @@ ZmqClient::~ZmqClient()
     {
         zmq_ctx_destroy(m_context);
     }
+
+    closeShmSocket();
 }
     
 void ZmqClient::initialize(const std::string& endpoint, const std::string& vrf)
@@ -57,7 +79,30 @@ void ZmqClient::initialize(const std::string& endpoint, const std::string& vrf)
     m_context = nullptr;
     m_socket = nullptr;
     m_vrf = vrf;
-    m_sendbuffer.resize(MQ_RESPONSE_MAX_COUNT);
+    m_async = false;
+    m_overflowPolicy = OverflowPolicy::BLOCK;
+    m_maxQueueSize = 0;
+    m_queueFrontSeq = 0;
+    m_sending = 0;
+    m_stopSendThread = false;
+    m_dropped = 0;
+    m_coalesced = 0;
+    m_sendErrors = 0;
+    m_lastRequestId = 0;
+    m_lastAckedRequestId = 0;
+    m_wireFormat = BinarySerializer::Format::V1;
+    m_wireFormatSet = false;
+    m_compression = ZmqCompression::NONE;
+    m_compressionThreshold = MQ_COMPRESSION_THRESHOLD;
+    m_peerCodecs = 0;
+    m_peerFormats = 0;
+    m_probeSent = false;
+    m_probeAnswered = false;
+    m_shmSocket = -1;
+    if (endpoint.compare(0, strlen(MQ_SHM_ENDPOINT_PREFIX), MQ_SHM_ENDPOINT_PREFIX) == 0)
+    {
+        m_shmPath = endpoint.substr(strlen(MQ_SHM_ENDPOINT_PREFIX));
+    }
 
     connect();
 }
@@ -76,6 +121,21 @@ void ZmqClient::connect()
     }
 
     std::lock_guard<std::mutex> lock(m_socketMutex);
+    if (!m_shmPath.empty())
+    {
+        // Messages are written to the ring until the server is there to take it over
+        if (!m_shmRing)
+        {
+            m_shmRing.reset(new ShmRing(MQ_SHM_RING_SIZE));
+        }
+
+        SWSS_LOG_NOTICE("connect to shared memory endpoint: %s", m_endpoint.c_str());
+        m_shmNextConnect = std::chrono::steady_clock::time_point();
+        shmHandOver();
+        m_connected = true;
+        return;
+    }
+
     if (m_socket)
     {
         int rc = zmq_close(m_socket);
@@ -91,8 +151,9 @@ void ZmqClient::connect()
     }
     
     // ZMQ Client/Server are n:1 mapping, so need use PUSH/PULL pattern http://api.zeromq.org/master:zmq-socket
+    // DEALER/ROUTER of the response path lets the server route the responses back
     m_context = zmq_ctx_new();
-    m_socket = zmq_socket(m_context, ZMQ_PUSH);
+    m_socket = zmq_socket(m_context, m_enableResponse ? ZMQ_DEALER : ZMQ_PUSH);
     
     // timeout all pending send package, so zmq will not block in dtor of this class: http://api.zeromq.org/master:zmq-setsockopt
     int linger = 0;
@@ -107,6 +168,14 @@ void ZmqClient::connect()
         zmq_setsockopt(m_socket, ZMQ_BINDTODEVICE, m_vrf.c_str(), m_vrf.length());
     }
 
+    // a new socket may reach another server, probe its codecs and formats again
+    m_probeSent = false;
+    m_probeAnswered = false;
+    if (!m_wireFormatSet)
+    {
+        m_wireFormat = BinarySerializer::Format::V1;
+    }
+
     SWSS_LOG_NOTICE("connect to zmq endpoint: %s", m_endpoint.c_str());
     int rc = zmq_connect(m_socket, m_endpoint.c_str());
     if (rc != 0)
@@ -125,21 +194,293 @@ void ZmqClient::sendMsg(
         const std::string& tableName,
         const std::vector<KeyOpFieldsValuesTuple>& kcos)
 {
-    int serializedlen = (int)BinarySerializer::serializeBuffer(
-                                                        m_sendbuffer.data(),
-                                                        m_sendbuffer.size(),
+    if (m_async)
+    {
+        enqueue(dbName, tableName, kcos);
+        return;
+    }
+
+    sendMsgNow(dbName, tableName, kcos);
+}
+
+void ZmqClient::enableAsyncSend(size_t maxQueueSize, OverflowPolicy policy)
+{
+    if (maxQueueSize == 0)
+    {
+        SWSS_LOG_THROW("ZmqClient async send queue size can't be 0");
+    }
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_maxQueueSize = maxQueueSize;
+    if (m_overflowPolicy != policy)
+    {
+        // only COALESCE tracks the queued keys
+        m_queuedKeys.clear();
+        m_overflowPolicy = policy;
+    }
+    if (!m_sendThread)
+    {
+        m_sendThread = std::make_shared<std::thread>(&ZmqClient::sendThread, this);
+    }
+    m_async = true;
+}
+
+void ZmqClient::enqueue(
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<KeyOpFieldsValuesTuple>& kcos)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        for (auto& kco : kcos)
+        {
+            if (m_overflowPolicy == OverflowPolicy::COALESCE)
+            {
+                std::string id = dbName + '\0' + tableName + '\0' + kfvKey(kco);
+                auto it = m_queuedKeys.find(id);
+                if (it != m_queuedKeys.end())
+                {
+                    coalesce(m_sendQueue[it->second - m_queueFrontSeq], kco);
+                    m_coalesced++;
+                    continue;
+                }
+
+                m_queueCv.wait(lock, [this] { return m_sendQueue.size() < m_maxQueueSize; });
+                m_queuedKeys[id] = m_queueFrontSeq + m_sendQueue.size();
+            }
+            else if (m_overflowPolicy == OverflowPolicy::DROP_OLDEST)
+            {
+                if (m_sendQueue.size() >= m_maxQueueSize)
+                {
+                    m_sendQueue.pop_front();
+                    m_queueFrontSeq++;
+                    m_dropped++;
+                }
+            }
+            else
+            {
+                m_queueCv.wait(lock, [this] { return m_sendQueue.size() < m_maxQueueSize; });
+            }
+
+            m_sendQueue.push_back(QueuedKco{dbName, tableName, kco, false});
+        }
+    }
+
+    m_queueCv.notify_all();
+}
+
+void ZmqClient::coalesce(QueuedKco& queued, const KeyOpFieldsValuesTuple& kco)
+{
+    // Same as the coalesced ProducerStateTable: a DEL drops the earlier SETs,
+    // a SET after a DEL recreates the key and the fields of SETs merge
+    auto& fields = kfvFieldsValues(queued.kco);
+    if (kfvOp(kco) == DEL_COMMAND)
+    {
+        kfvOp(queued.kco) = DEL_COMMAND;
+        fields.clear();
+        queued.delBeforeSet = false;
+        return;
+    }
+
+    if (kfvOp(queued.kco) == DEL_COMMAND)
+    {
+        queued.delBeforeSet = true;
+        kfvOp(queued.kco) = kfvOp(kco);
+    }
+
+    for (const auto& iv : kfvFieldsValues(kco))
+    {
+        // entries have a few fields, a linear search beats a map
+        auto field = std::find_if(fields.begin(), fields.end(), [&iv](const FieldValueTuple& fv) {
+            return fvField(fv) == fvField(iv);
+        });
+        if (field != fields.end())
+        {
+            fvValue(*field) = fvValue(iv);
+        }
+        else
+        {
+            fields.push_back(iv);
+        }
+    }
+}
+
+void ZmqClient::sendThread()
+{
+    SWSS_LOG_ENTER();
+
+    std::deque<QueuedKco> batch;
+    std::vector<KeyOpFieldsValuesTuple> kcos;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_sending = 0;
+            m_queueCv.notify_all();
+
+            m_queueCv.wait(lock, [this] { return !m_sendQueue.empty() || m_stopSendThread; });
+            if (m_sendQueue.empty())
+            {
+                break;
+            }
+
+            batch.swap(m_sendQueue);
+            m_queueFrontSeq += batch.size();
+            m_queuedKeys.clear();
+            m_sending = batch.size();
+        }
+        m_queueCv.notify_all();
+
+        // Send every run of operations on the same table as one message
+        size_t begin = 0;
+        while (begin < batch.size())
+        {
+            size_t end = begin;
+            kcos.clear();
+            while (end < batch.size()
+                   && batch[end].tableName == batch[begin].tableName
+                   && batch[end].dbName == batch[begin].dbName)
+            {
+                if (batch[end].delBeforeSet)
+                {
+                    kcos.emplace_back(kfvKey(batch[end].kco), DEL_COMMAND, std::vector<FieldValueTuple>());
+                }
+                kcos.push_back(std::move(batch[end].kco));
+                end++;
+            }
+
+            try
+            {
+                sendMsgNow(batch[begin].dbName, batch[begin].tableName, kcos);
+            }
+            catch (const std::exception& e)
+            {
+                SWSS_LOG_ERROR("ZmqClient async send dropped %zu operations of table %s: %s", kcos.size(), batch[begin].tableName.c_str(), e.what());
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_sendErrors++;
+                m_dropped += kcos.size();
+            }
+
+            begin = end;
+        }
+        batch.clear();
+    }
+}
+
+bool ZmqClient::waitDrained(uint32_t timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    return m_queueCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+        return m_sendQueue.empty() && m_sending == 0;
+    });
+}
+
+void ZmqClient::flush()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueCv.wait(lock, [this] { return m_sendQueue.empty() && m_sending == 0; });
+}
+
+size_t ZmqClient::getQueueDepth()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_sendQueue.size() + m_sending;
+}
+
+uint64_t ZmqClient::getDroppedCount()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_dropped;
+}
+
+uint64_t ZmqClient::getCoalescedCount()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_coalesced;
+}
+
+uint64_t ZmqClient::getSendErrorCount()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_sendErrors;
+}
+
+void ZmqClient::sendMsgNow(
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<KeyOpFieldsValuesTuple>& kcos)
+{
+    if (m_shmRing)
+    {
+        sendShmMsg(dbName, tableName, kcos);
+        return;
+    }
+
+    BinarySerializer::Format format;
+    auto codec = negotiate(format);
+
+    // Serialize straight into the message buffer, so there is no limit on
+    // the batch size and ZMQ sends the message without copying it.
+    // The V2 size is an upper bound, the message takes the serialized length.
+    size_t bufferSize = BinarySerializer::serializedSize(dbName, tableName, kcos, format);
+    std::unique_ptr<char, void(*)(void*)> buffer(static_cast<char*>(malloc(bufferSize)), free);
+    if (!buffer)
+    {
+        SWSS_LOG_THROW("ZmqClient sendMsg failed to allocate %zu bytes", bufferSize);
+    }
+
+    size_t serializedlen = BinarySerializer::serializeBuffer(
+                                                        buffer.get(),
+                                                        bufferSize,
                                                         dbName,
                                                         tableName,
-                                                        kcos);
+                                                        kcos,
+                                                        format);
+
+    // Compress big messages once the server confirmed the codec
+    ZmqCompressionStats stats;
+    if (serializedlen < m_compressionThreshold)
+    {
+        codec = ZmqCompression::NONE;
+    }
+    else if (codec != ZmqCompression::NONE)
+    {
+        size_t compressedSize = ZmqCompressor::compressBound(codec, serializedlen);
+        std::unique_ptr<char, void(*)(void*)> compressed(static_cast<char*>(malloc(compressedSize)), free);
+        if (compressed)
+        {
+            compressedSize = ZmqCompressor::compress(codec, buffer.get(), serializedlen, compressed.get(), compressedSize, stats);
+        }
 
-    if (serializedlen >= MQ_RESPONSE_MAX_COUNT)
+        if (compressed && compressedSize > 0)
+        {
+            buffer = std::move(compressed);
+            serializedlen = compressedSize;
+        }
+        else
+        {
+            // the message doesn't shrink
+            codec = ZmqCompression::NONE;
+        }
+    }
+
+    zmq_msg_t msg;
+    if (zmq_msg_init_data(&msg, buffer.get(), serializedlen, [](void *data, void *) { free(data); }, nullptr) != 0)
     {
-        SWSS_LOG_THROW("ZmqClient sendMsg message was too big (buffer size %d bytes, got %d), reduce the message size, message DROPPED",
-                MQ_RESPONSE_MAX_COUNT,
-                serializedlen);
+        SWSS_LOG_THROW("ZmqClient sendMsg failed to create message of %zu bytes, zmqerrno: %d", serializedlen, zmq_errno());
     }
+    buffer.release();
 
-    SWSS_LOG_DEBUG("sending: %d", serializedlen);
+    // The request id, followed by the codec of a compressed payload
+    char idFrame[sizeof(uint64_t) + 1];
+    size_t idFrameSize = sizeof(uint64_t);
+    if (codec != ZmqCompression::NONE)
+    {
+        idFrame[idFrameSize++] = static_cast<char>(codec);
+    }
+
+    SWSS_LOG_DEBUG("sending: %zu", serializedlen);
+    uint64_t requestId = 0;
     int zmq_err = 0;
     int retry_delay = 10;
     int rc = 0;
@@ -149,12 +490,31 @@ void ZmqClient::sendMsg(
             // ZMQ socket is not thread safe: http://api.zeromq.org/2-1:zmq
             std::lock_guard<std::mutex> lock(m_socketMutex);
 
+            // The request id frame goes first, multipart messages are atomic so
+            // the payload frame can't fail on high watermark once the id frame is queued.
+            // A PUSH client only sends the payload.
+            requestId = m_enableResponse ? m_lastRequestId + 1 : 0;
+            memcpy(idFrame, &requestId, sizeof(requestId));
             // Use none block mode to use all bandwidth: http://api.zeromq.org/2-1%3Azmq-send
-            rc = zmq_send(m_socket, m_sendbuffer.data(), serializedlen, ZMQ_NOBLOCK);
+            rc = m_enableResponse ? zmq_send(m_socket, idFrame, idFrameSize, ZMQ_NOBLOCK | ZMQ_SNDMORE) : 0;
+            if (rc >= 0)
+            {
+                // The message is owned by ZMQ on success
+                rc = zmq_msg_send(&msg, m_socket, m_enableResponse ? 0 : ZMQ_NOBLOCK);
+                if (rc >= 0)
+                {
+                    m_lastRequestId = requestId;
+                    m_compressionStats.messages += stats.messages;
+                    m_compressionStats.uncompressedBytes += stats.uncompressedBytes;
+                    m_compressionStats.compressedBytes += stats.compressedBytes;
+                }
+            }
+            m_compressionStats.cpuTimeNs += stats.cpuTimeNs;
+            stats.cpuTimeNs = 0;
         }
         if (rc >= 0)
         {
-            SWSS_LOG_DEBUG("zmq sended %d bytes", serializedlen);
+            SWSS_LOG_DEBUG("zmq sended request %" PRIu64 ", %zu bytes", requestId, serializedlen);
             return;
         }
 
@@ -180,6 +540,7 @@ void ZmqClient::sendMsg(
         }
         else if (zmq_err == ETERM)
         {
+            zmq_msg_close(&msg);
             m_connected = false;
             auto message =  "zmq connection break, endpoint: " + m_endpoint + ", error: " + to_string(rc);
             SWSS_LOG_ERROR("%s", message.c_str());
@@ -188,6 +549,7 @@ void ZmqClient::sendMsg(
         else
         {
             // for other error, send failed immediately.
+            zmq_msg_close(&msg);
             auto message =  "zmq send failed, endpoint: " + m_endpoint + ", error: " + to_string(rc);
             SWSS_LOG_ERROR("%s", message.c_str());
             throw system_error(make_error_code(errc::io_error), message);
@@ -197,16 +559,451 @@ void ZmqClient::sendMsg(
     }
 
     // failed after retry
+    zmq_msg_close(&msg);
     auto message =  "zmq send failed, endpoint: " + m_endpoint + ", zmqerrno: " + to_string(zmq_err) + ":" + zmq_strerror(zmq_err) + ", msg length:" + to_string(serializedlen);
     SWSS_LOG_ERROR("%s", message.c_str());
     throw system_error(make_error_code(errc::io_error), message);
 }
 
-// TODO: To be implemented later, required for ZMQ_CLIENT & ZMQ_SERVER
-// socket types in response path.
+void ZmqClient::sendShmMsg(
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<KeyOpFieldsValuesTuple>& kcos)
+{
+    // The record is the request id and the message, serialized in place
+    // into the ring, the server reads it from there.
+    size_t bufferSize = sizeof(uint64_t) + BinarySerializer::serializedSize(dbName, tableName, kcos, m_wireFormat);
+    if (bufferSize > m_shmRing->getMaxMessageSize())
+    {
+        auto message = "shared memory send failed, endpoint: " + m_endpoint + ", msg length:" + to_string(bufferSize);
+        SWSS_LOG_ERROR("%s", message.c_str());
+        throw system_error(make_error_code(errc::message_size), message);
+    }
+
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    if (m_shmSocket >= 0)
+    {
+        // A restarted server takes the ring over right away, the check doesn't block
+        struct pollfd pfd = { m_shmSocket, POLLRDHUP, 0 };
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLRDHUP | POLLERR)))
+        {
+            // keep the responses the server sent before it went away
+            while (recvShmMessage())
+            {
+            }
+            closeShmSocket();
+        }
+    }
+    shmHandOver();
+    char* buffer = m_shmRing->reserve(bufferSize, 0);
+    if (buffer == nullptr)
+    {
+        // The ring is full, take it over to a restarted server and wait for room
+        while (recvShmMessage())
+        {
+        }
+        shmHandOver();
+
+        SWSS_LOG_WARN("shared memory ring is full, endpoint: %s", m_endpoint.c_str());
+        buffer = m_shmRing->reserve(bufferSize, MQ_SHM_SEND_TIMEOUT_MS);
+        if (buffer == nullptr)
+        {
+            auto message = "shared memory send timeout, endpoint: " + m_endpoint + ", msg length:" + to_string(bufferSize);
+            SWSS_LOG_ERROR("%s", message.c_str());
+            throw system_error(make_error_code(errc::io_error), message);
+        }
+    }
+
+    uint64_t requestId = m_lastRequestId + 1;
+    memcpy(buffer, &requestId, sizeof(requestId));
+    size_t serializedlen = BinarySerializer::serializeBuffer(
+                                                        buffer + sizeof(requestId),
+                                                        bufferSize - sizeof(requestId),
+                                                        dbName,
+                                                        tableName,
+                                                        kcos,
+                                                        m_wireFormat);
+    m_shmRing->commit(sizeof(requestId) + serializedlen);
+    m_lastRequestId = requestId;
+    SWSS_LOG_DEBUG("shared memory sended request %" PRIu64 ", %zu bytes", requestId, serializedlen);
+}
+
+bool ZmqClient::shmHandOver()
+{
+    if (m_shmSocket >= 0)
+    {
+        return true;
+    }
+
+    // At most one attempt per MQ_POLL_TIMEOUT while the server is down
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_shmNextConnect)
+    {
+        return false;
+    }
+
+    int sock = ShmConnection::connect(m_shmPath);
+    if (sock < 0)
+    {
+        m_shmNextConnect = now + std::chrono::milliseconds(MQ_POLL_TIMEOUT);
+        return false;
+    }
+
+    try
+    {
+        ShmConnection::sendRing(sock, *m_shmRing);
+    }
+    catch (const std::exception& e)
+    {
+        SWSS_LOG_WARN("failed to hand over shared memory ring, endpoint: %s: %s", m_endpoint.c_str(), e.what());
+        close(sock);
+        m_shmNextConnect = now + std::chrono::milliseconds(MQ_POLL_TIMEOUT);
+        return false;
+    }
+
+    SWSS_LOG_NOTICE("shared memory ring handed over, endpoint: %s", m_endpoint.c_str());
+    m_shmSocket = sock;
+    m_shmRecvBuffer.clear();
+    return true;
+}
+
+bool ZmqClient::recvShmMessage()
+{
+    if (m_shmSocket < 0)
+    {
+        return false;
+    }
+
+    char buffer[4096];
+    ssize_t rc = recv(m_shmSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (rc < 0 && (errno == EINTR || errno == EAGAIN))
+    {
+        return false;
+    }
+    if (rc <= 0)
+    {
+        // The server is gone, the ring goes to the next server
+        SWSS_LOG_WARN("shared memory server closed, endpoint: %s", m_endpoint.c_str());
+        closeShmSocket();
+        return false;
+    }
+    m_shmRecvBuffer.append(buffer, static_cast<size_t>(rc));
+
+    // A response frame is its size, the acked request id and the payload
+    size_t offset = 0;
+    uint64_t frameSize;
+    while (m_shmRecvBuffer.size() - offset >= sizeof(frameSize))
+    {
+        memcpy(&frameSize, m_shmRecvBuffer.data() + offset, sizeof(frameSize));
+        if (frameSize < sizeof(uint64_t) || frameSize > MQ_MAX_DECOMPRESSED_SIZE)
+        {
+            SWSS_LOG_WARN("ZmqClient dropped malformed response of %zu bytes, endpoint: %s", static_cast<size_t>(frameSize), m_endpoint.c_str());
+            closeShmSocket();
+            return false;
+        }
+        if (m_shmRecvBuffer.size() - offset - sizeof(frameSize) < frameSize)
+        {
+            break;
+        }
+
+        auto frame = m_shmRecvBuffer.data() + offset + sizeof(frameSize);
+        Response response;
+        memcpy(&response.requestId, frame, sizeof(uint64_t));
+        offset += sizeof(frameSize) + static_cast<size_t>(frameSize);
+        BinarySerializer::deserializeBuffer(frame + sizeof(uint64_t),
+                                            static_cast<size_t>(frameSize) - sizeof(uint64_t),
+                                            response.dbName,
+                                            response.tableName,
+                                            response.kcos);
+
+        if (response.requestId > m_lastAckedRequestId)
+        {
+            m_lastAckedRequestId = response.requestId;
+        }
+        m_responses.push_back(std::move(response));
+    }
+    m_shmRecvBuffer.erase(0, offset);
+
+    return true;
+}
+
+void ZmqClient::closeShmSocket()
+{
+    if (m_shmSocket >= 0)
+    {
+        close(m_shmSocket);
+        m_shmSocket = -1;
+    }
+    m_shmRecvBuffer.clear();
+}
+
 bool ZmqClient::wait(
-    const std::string &dbName, const std::string &tableName,
-    const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &kcos) {
-  return false;
+        const std::string& /*dbName*/,
+        const std::string& /*tableName*/,
+        const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& /*kcos*/)
+{
+    std::string dbName;
+    std::string tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    return wait(dbName, tableName, kcos);
+}
+
+bool ZmqClient::wait(
+        std::string& dbName,
+        std::string& tableName,
+        std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos)
+{
+    uint64_t requestId;
+    return wait(dbName, tableName, kcos, requestId, m_waitTimeMs);
+}
+
+bool ZmqClient::wait(
+        std::string& dbName,
+        std::string& tableName,
+        std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos,
+        uint64_t& requestId,
+        uint32_t timeoutMs)
+{
+    SWSS_LOG_ENTER();
+
+    if (!m_enableResponse && !m_shmRing)
+    {
+        // nothing can be received on PUSH
+        return false;
+    }
+
+    // Poll in short slices, the socket is shared with the senders
+    const long pollSliceMs = 10;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true)
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                deadline - std::chrono::steady_clock::now()).count();
+        {
+            std::lock_guard<std::mutex> lock(m_socketMutex);
+            if (m_responses.empty() && m_shmRing && !shmHandOver())
+            {
+                // no server to answer yet
+                usleep(static_cast<useconds_t>(std::max(0L, std::min<long>(remaining, pollSliceMs)) * 1000));
+            }
+            else if (m_responses.empty())
+            {
+                zmq_pollitem_t poll_item;
+                poll_item.fd = m_shmSocket;
+                poll_item.socket = m_shmRing ? nullptr : m_socket;
+                poll_item.events = ZMQ_POLLIN;
+                poll_item.revents = 0;
+
+                int rc = zmq_poll(&poll_item, 1, std::max(0L, std::min<long>(remaining, pollSliceMs)));
+                if (rc < 0 && zmq_errno() != EINTR)
+                {
+                    SWSS_LOG_THROW("zmq_poll failed, endpoint: %s, zmqerrno: %d", m_endpoint.c_str(), zmq_errno());
+                }
+
+                while (rc > 0 && recvMessage())
+                {
+                }
+            }
+
+            if (!m_responses.empty())
+            {
+                auto& response = m_responses.front();
+                dbName = std::move(response.dbName);
+                tableName = std::move(response.tableName);
+                kcos = std::move(response.kcos);
+                requestId = response.requestId;
+                m_responses.pop_front();
+                return true;
+            }
+        }
+
+        if (remaining <= 0)
+        {
+            return false;
+        }
+    }
+}
+
+bool ZmqClient::recvMessage()
+{
+    if (m_shmRing)
+    {
+        return recvShmMessage();
+    }
+
+    // A message of the server is the acked request id frame followed by the
+    // payload frame, zmq_msg_t can't be copied so unexpected extra frames go
+    // to the last one.
+    zmq_msg_t frames[2];
+    zmq_msg_init(&frames[0]);
+    zmq_msg_init(&frames[1]);
+    size_t frameCount = 0;
+    int more = 1;
+    while (more)
+    {
+        auto& frame = frames[std::min<size_t>(frameCount, 1)];
+        zmq_msg_close(&frame);
+        zmq_msg_init(&frame);
+        if (zmq_msg_recv(&frame, m_socket, ZMQ_DONTWAIT) < 0)
+        {
+            int zmq_err = zmq_errno();
+            zmq_msg_close(&frames[0]);
+            zmq_msg_close(&frames[1]);
+            if (zmq_err == EINTR || zmq_err == EAGAIN)
+            {
+                return false;
+            }
+            SWSS_LOG_THROW("zmq_recv failed, endpoint: %s, zmqerrno: %d", m_endpoint.c_str(), zmq_err);
+        }
+        more = zmq_msg_more(&frame);
+        frameCount++;
+    }
+
+    auto idFrame = static_cast<const char*>(zmq_msg_data(&frames[0]));
+    auto idFrameSize = zmq_msg_size(&frames[0]);
+    auto payload = static_cast<const char*>(zmq_msg_data(&frames[1]));
+    auto payloadSize = zmq_msg_size(&frames[1]);
+    if (frameCount == 2 && idFrameSize == sizeof(uint64_t) + 1
+        && static_cast<uint8_t>(idFrame[sizeof(uint64_t)]) == MQ_CODEC_PROBE && payloadSize >= 1)
+    {
+        // the answer of the probe, the codecs shared with the server and its formats
+        m_peerCodecs = static_cast<uint8_t>(payload[0]);
+        m_peerFormats = payloadSize > 1 ? static_cast<uint8_t>(payload[1]) : 0;
+        m_probeAnswered = true;
+        if (!m_wireFormatSet && (m_peerFormats & MQ_PROBE_FORMAT_V2))
+        {
+            m_wireFormat = BinarySerializer::Format::V2_FIELD_DICTIONARY;
+        }
+        SWSS_LOG_NOTICE("ZmqClient endpoint %s supports codecs 0x%x, formats 0x%x", m_endpoint.c_str(), m_peerCodecs, m_peerFormats);
+    }
+    else if (frameCount == 2 && idFrameSize == sizeof(uint64_t))
+    {
+        Response response;
+        memcpy(&response.requestId, idFrame, sizeof(uint64_t));
+        try
+        {
+            BinarySerializer::deserializeBuffer(payload,
+                                                payloadSize,
+                                                response.dbName,
+                                                response.tableName,
+                                                response.kcos);
+        }
+        catch (...)
+        {
+            zmq_msg_close(&frames[0]);
+            zmq_msg_close(&frames[1]);
+            throw;
+        }
+
+        // Requests are acked in order, a response acks all the earlier ones
+        if (response.requestId > m_lastAckedRequestId)
+        {
+            m_lastAckedRequestId = response.requestId;
+        }
+        m_responses.push_back(std::move(response));
+    }
+    else
+    {
+        SWSS_LOG_WARN("ZmqClient dropped malformed response with %zu frames, endpoint: %s", frameCount, m_endpoint.c_str());
+    }
+
+    zmq_msg_close(&frames[0]);
+    zmq_msg_close(&frames[1]);
+
+    return true;
+}
+
+ZmqCompression ZmqClient::negotiate(BinarySerializer::Format& format)
+{
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    format = m_wireFormat;
+    if (m_shmRing || !m_enableResponse)
+    {
+        // nothing to save by compressing shared memory, and the
+        // codecs of a server without response path are unknown
+        return ZmqCompression::NONE;
+    }
+
+    if (!m_probeSent && (m_compression != ZmqCompression::NONE || !m_wireFormatSet))
+    {
+        // The probe is the codec mask of the client, with request id 0
+        char idFrame[sizeof(uint64_t) + 1] = {};
+        idFrame[sizeof(uint64_t)] = static_cast<char>(MQ_CODEC_PROBE);
+        uint8_t codecs = ZmqCompressor::supportedCodecs();
+        if (zmq_send(m_socket, idFrame, sizeof(idFrame), ZMQ_NOBLOCK | ZMQ_SNDMORE) >= 0)
+        {
+            zmq_send(m_socket, &codecs, sizeof(codecs), 0);
+            m_probeSent = true;
+        }
+    }
+
+    // Pick up the answer, the responses are kept for wait()
+    while (m_probeSent && !m_probeAnswered && recvMessage())
+    {
+    }
+
+    format = m_wireFormat;
+    if (m_compression != ZmqCompression::NONE && m_probeAnswered && ZmqCompressor::isSupported(m_peerCodecs, m_compression))
+    {
+        return m_compression;
+    }
+
+    return ZmqCompression::NONE;
 }
+
+void ZmqClient::enableCompression(ZmqCompression codec, size_t thresholdBytes)
+{
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    if (codec != ZmqCompression::NONE && !ZmqCompressor::isSupported(ZmqCompressor::supportedCodecs(), codec))
+    {
+        SWSS_LOG_THROW("ZmqClient doesn't support codec %u", static_cast<unsigned>(codec));
+    }
+
+    m_compression = codec;
+    m_compressionThreshold = thresholdBytes;
+}
+
+ZmqCompression ZmqClient::getNegotiatedCompression()
+{
+    BinarySerializer::Format format;
+    return negotiate(format);
+}
+
+ZmqCompressionStats ZmqClient::getCompressionStats()
+{
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    return m_compressionStats;
+}
+
+void ZmqClient::setWireFormat(BinarySerializer::Format format)
+{
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    m_wireFormat = format;
+    m_wireFormatSet = true;
+}
+
+BinarySerializer::Format ZmqClient::getWireFormat()
+{
+    BinarySerializer::Format format;
+    negotiate(format);
+    return format;
+}
+
+uint64_t ZmqClient::getLastRequestId()
+{
+    return m_lastRequestId;
+}
+
+uint64_t ZmqClient::getLastAckedRequestId()
+{
+    return m_lastAckedRequestId;
+}
+
+uint64_t ZmqClient::getOutstandingRequestCount()
+{
+    uint64_t acked = m_lastAckedRequestId;
+    uint64_t sent = m_lastRequestId;
+    return sent > acked ? sent - acked : 0;
+}
+
 }
@@ -5,17 +5,39 @@
 #include <queue>
 #include <thread> 
 #include <mutex> 
+#include <deque>
+#include <unordered_map>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include "zmqserver.h"
+#include "binaryserializer.h"
 
 namespace swss {
 
+class ShmRing;
+
 class ZmqClient
 {
 public:
+    /* What sendMsg() does when the async send queue is full */
+    enum class OverflowPolicy
+    {
+        BLOCK,          // wait for the sender thread to make room
+        DROP_OLDEST,    // drop the oldest queued operations
+        COALESCE,       // merge into the queued operation of the same key, block if the key is not queued
+    };
 
     ZmqClient(const std::string& endpoint);
     ZmqClient(const std::string& endpoint, const std::string& vrf);
-    ZmqClient(const std::string& endpoint, uint32_t waitTimeMs);
+    /*
+     * With enableResponse, the client connects a DEALER socket to a ZmqServer
+     * with enableResponse, the server can respond to the requests and the
+     * messages may be compressed. Otherwise the client connects a PUSH socket
+     * and sends only the payload, as the servers without response path expect.
+     * A shm:// endpoint always has a response path.
+     */
+    ZmqClient(const std::string& endpoint, uint32_t waitTimeMs, bool enableResponse = false);
     ~ZmqClient();
 
     bool isConnected();
@@ -26,13 +48,129 @@ public:
                  const std::string& tableName,
                  const std::vector<KeyOpFieldsValuesTuple>& kcos);
 
+    /*
+     * With a response path, every message sent by sendMsg() is a request
+     * with an increasing id, the server answers with ZmqServer::sendMsg().
+     * A response acks every request of the client up to its id, so the
+     * producer can keep many batches outstanding and collect the responses
+     * later.
+     * Wait up to the wait time of the client for the next response and
+     * drop it, false on timeout or without response path.
+     */
     bool wait(const std::string& dbName,
               const std::string& tableName,
               const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos);
 
+    /* Same as above, return the response */
+    bool wait(std::string& dbName,
+              std::string& tableName,
+              std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos);
+
+    /* Same as above, also return the id of the acked request */
+    bool wait(std::string& dbName,
+              std::string& tableName,
+              std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos,
+              uint64_t& requestId,
+              uint32_t timeoutMs);
+
+    /*
+     * Wire format of the sent messages, V1 by default as every server decodes
+     * it. With a response path, the client switches to V2 with field dictionary
+     * once the server confirmed it decodes V2, unless the format was set.
+     */
+    void setWireFormat(BinarySerializer::Format format);
+
+    BinarySerializer::Format getWireFormat();
+
+    /*
+     * Compress the messages of at least thresholdBytes with codec, once the
+     * server confirmed it supports the codec. Until then, and when a message
+     * doesn't shrink, the messages are sent uncompressed.
+     */
+    void enableCompression(ZmqCompression codec, size_t thresholdBytes = MQ_COMPRESSION_THRESHOLD);
+
+    /* The codec in use, NONE until the server confirmed it, probe the server if needed */
+    ZmqCompression getNegotiatedCompression();
+
+    ZmqCompressionStats getCompressionStats();
+
+    /* Id of the last request sent, 0 if none */
+    uint64_t getLastRequestId();
+
+    /* Id of the last request acked by a response, 0 if none */
+    uint64_t getLastAckedRequestId();
+
+    /* Requests sent and not acked yet */
+    uint64_t getOutstandingRequestCount();
+
+    /*
+     * Make sendMsg() queue the operations and return immediately, a sender
+     * thread sends them in batches. Send failures are counted and logged
+     * since they can't be reported to the caller any more.
+     */
+    void enableAsyncSend(size_t maxQueueSize, OverflowPolicy policy = OverflowPolicy::BLOCK);
+
+    /* Wait until every queued operation is sent, false on timeout */
+    bool waitDrained(uint32_t timeoutMs);
+
+    /* Wait until every queued operation is sent */
+    void flush();
+
+    size_t getQueueDepth();
+
+    uint64_t getDroppedCount();
+
+    uint64_t getCoalescedCount();
+
+    uint64_t getSendErrorCount();
+
 private:
     void initialize(const std::string& endpoint, const std::string& vrf = "");
 
+    void sendMsgNow(const std::string& dbName,
+                    const std::string& tableName,
+                    const std::vector<KeyOpFieldsValuesTuple>& kcos);
+
+    bool recvMessage();
+
+    void sendShmMsg(const std::string& dbName,
+                    const std::string& tableName,
+                    const std::vector<KeyOpFieldsValuesTuple>& kcos);
+
+    bool shmHandOver();
+
+    bool recvShmMessage();
+
+    void closeShmSocket();
+
+    /* Probe the server once, return the codec and the wire format to send with */
+    ZmqCompression negotiate(BinarySerializer::Format& format);
+
+    struct Response
+    {
+        std::string dbName;
+        std::string tableName;
+        std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+        uint64_t requestId;
+    };
+
+    void enqueue(const std::string& dbName,
+                 const std::string& tableName,
+                 const std::vector<KeyOpFieldsValuesTuple>& kcos);
+
+    void sendThread();
+
+    struct QueuedKco
+    {
+        std::string dbName;
+        std::string tableName;
+        KeyOpFieldsValuesTuple kco;
+        // a coalesced DEL is sent before the SET of kco
+        bool delBeforeSet;
+    };
+
+    void coalesce(QueuedKco& queued, const KeyOpFieldsValuesTuple& kco);
+
     std::string m_endpoint;
 
     std::string m_vrf;
@@ -45,9 +183,83 @@ private:
 
     uint32_t m_waitTimeMs;
 
+    bool m_enableResponse;
+
     std::mutex m_socketMutex;
 
-    std::vector<char> m_sendbuffer;
+    std::atomic<uint64_t> m_lastRequestId;
+
+    std::atomic<uint64_t> m_lastAckedRequestId;
+
+    BinarySerializer::Format m_wireFormat;
+
+    // set by setWireFormat(), not negotiated
+    bool m_wireFormatSet;
+
+    // Responses received while sending, waiting for wait()
+    std::deque<Response> m_responses;
+
+    ZmqCompression m_compression;
+
+    size_t m_compressionThreshold;
+
+    // Codecs and MQ_PROBE_FORMAT_V2 of the server, valid once the probe is answered
+    uint8_t m_peerCodecs;
+
+    uint8_t m_peerFormats;
+
+    bool m_probeSent;
+
+    bool m_probeAnswered;
+
+    ZmqCompressionStats m_compressionStats;
+
+    // Unix socket path of a shm:// endpoint, empty for ZMQ
+    std::string m_shmPath;
+
+    // Written by this client, read by the server in place
+    std::unique_ptr<ShmRing> m_shmRing;
+
+    // Connection to the server holding the ring, carries the responses
+    int m_shmSocket;
+
+    // Partial response frames read from m_shmSocket
+    std::string m_shmRecvBuffer;
+
+    // No server to take the ring over before then, the sends keep writing
+    // to the ring without trying to connect on every message
+    std::chrono::steady_clock::time_point m_shmNextConnect;
+
+    std::atomic<bool> m_async;
+
+    OverflowPolicy m_overflowPolicy;
+
+    size_t m_maxQueueSize;
+
+    std::mutex m_queueMutex;
+
+    std::condition_variable m_queueCv;
+
+    std::deque<QueuedKco> m_sendQueue;
+
+    // Sequence number of m_sendQueue.front(), to locate the coalesced operations
+    uint64_t m_queueFrontSeq;
+
+    // db, table and key of the queued operations to their sequence number
+    std::unordered_map<std::string, uint64_t> m_queuedKeys;
+
+    // operations taken by the sender thread and not sent yet
+    size_t m_sending;
+
+    bool m_stopSendThread;
+
+    uint64_t m_dropped;
+
+    uint64_t m_coalesced;
+
+    uint64_t m_sendErrors;
+
+    std::shared_ptr<std::thread> m_sendThread;
 };
 
 }
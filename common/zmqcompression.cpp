@@ -0,0 +1,136 @@
+#include <time.h>
+#include <string.h>
+#include <limits>
+#include <lz4.h>
+#include <zstd.h>
+#include "logger.h"
+#include "zmqcompression.h"
+
+using namespace std;
+
+namespace swss {
+
+/* zstd level 1 is close to LZ4 in speed with a better ratio */
+static const int ZSTD_LEVEL = 1;
+
+static uint64_t threadCpuTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint8_t ZmqCompressor::supportedCodecs()
+{
+    return (1 << static_cast<uint8_t>(ZmqCompression::LZ4)) | (1 << static_cast<uint8_t>(ZmqCompression::ZSTD));
+}
+
+bool ZmqCompressor::isSupported(uint8_t codecs, ZmqCompression codec)
+{
+    return codec != ZmqCompression::NONE && (codecs & (1 << static_cast<uint8_t>(codec)));
+}
+
+size_t ZmqCompressor::compressBound(ZmqCompression codec, size_t size)
+{
+    switch (codec)
+    {
+        case ZmqCompression::LZ4:
+            if (size > static_cast<size_t>(numeric_limits<int>::max() / 2))
+            {
+                // too big for the int API of LZ4, sent uncompressed
+                return 0;
+            }
+            return sizeof(uint64_t) + static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+        case ZmqCompression::ZSTD:
+            return sizeof(uint64_t) + ZSTD_compressBound(size);
+        default:
+            return 0;
+    }
+}
+
+size_t ZmqCompressor::compress(ZmqCompression codec, const char* data, size_t size, char* output, size_t capacity, ZmqCompressionStats& stats)
+{
+    size_t bound = compressBound(codec, size);
+    if (bound == 0 || capacity < bound)
+    {
+        return 0;
+    }
+
+    auto start = threadCpuTimeNs();
+    uint64_t rawSize = size;
+    memcpy(output, &rawSize, sizeof(rawSize));
+
+    size_t compressed = 0;
+    if (codec == ZmqCompression::LZ4)
+    {
+        int rc = LZ4_compress_default(data, output + sizeof(rawSize), static_cast<int>(size), static_cast<int>(capacity - sizeof(rawSize)));
+        compressed = rc > 0 ? static_cast<size_t>(rc) : 0;
+    }
+    else if (codec == ZmqCompression::ZSTD)
+    {
+        size_t rc = ZSTD_compress(output + sizeof(rawSize), capacity - sizeof(rawSize), data, size, ZSTD_LEVEL);
+        compressed = ZSTD_isError(rc) ? 0 : rc;
+    }
+    stats.cpuTimeNs += threadCpuTimeNs() - start;
+
+    if (compressed == 0 || compressed + sizeof(rawSize) >= size)
+    {
+        return 0;
+    }
+
+    stats.messages++;
+    stats.uncompressedBytes += size;
+    stats.compressedBytes += compressed + sizeof(rawSize);
+    return compressed + sizeof(rawSize);
+}
+
+size_t ZmqCompressor::decompressedSize(const char* data, size_t size)
+{
+    uint64_t rawSize;
+    if (size < sizeof(rawSize))
+    {
+        SWSS_LOG_THROW("compressed message was truncated, size: %zu", size);
+    }
+
+    memcpy(&rawSize, data, sizeof(rawSize));
+    if (rawSize > MQ_MAX_DECOMPRESSED_SIZE)
+    {
+        SWSS_LOG_THROW("compressed message is too big, uncompressed size: %zu", static_cast<size_t>(rawSize));
+    }
+
+    return static_cast<size_t>(rawSize);
+}
+
+void ZmqCompressor::decompress(ZmqCompression codec, const char* data, size_t size, char* output, size_t outputSize, ZmqCompressionStats& stats)
+{
+    if (decompressedSize(data, size) != outputSize)
+    {
+        SWSS_LOG_THROW("decompress buffer size %zu doesn't match the message", outputSize);
+    }
+
+    auto start = threadCpuTimeNs();
+    auto compressed = data + sizeof(uint64_t);
+    auto compressedSize = size - sizeof(uint64_t);
+    bool ok = false;
+    if (codec == ZmqCompression::LZ4)
+    {
+        ok = compressedSize <= static_cast<size_t>(numeric_limits<int>::max())
+            && LZ4_decompress_safe(compressed, output, static_cast<int>(compressedSize), static_cast<int>(outputSize)) == static_cast<int>(outputSize);
+    }
+    else if (codec == ZmqCompression::ZSTD)
+    {
+        ok = ZSTD_decompress(output, outputSize, compressed, compressedSize) == outputSize;
+    }
+    stats.cpuTimeNs += threadCpuTimeNs() - start;
+
+    if (!ok)
+    {
+        SWSS_LOG_THROW("failed to decompress message of codec %u, size: %zu", static_cast<unsigned>(codec), size);
+    }
+
+    stats.messages++;
+    stats.uncompressedBytes += outputSize;
+    stats.compressedBytes += size;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+/* Messages smaller than this are sent uncompressed by default */
+#define MQ_COMPRESSION_THRESHOLD 1024
+
+/* Refuse to decompress a message claiming to be bigger than this */
+#define MQ_MAX_DECOMPRESSED_SIZE (1024 * 1024 * 1024)
+
+namespace swss {
+
+/* Codec of a compressed ZMQ message, the values are sent on the wire */
+enum class ZmqCompression : uint8_t
+{
+    NONE = 0,
+    LZ4 = 1,    // fast, for busy links and CPUs
+    ZSTD = 2,   // better ratio for slow management links
+};
+
+/* Compression counters of one side of a ZMQ connection */
+struct ZmqCompressionStats
+{
+    uint64_t messages = 0;          // messages compressed or decompressed
+    uint64_t uncompressedBytes = 0;
+    uint64_t compressedBytes = 0;
+    uint64_t cpuTimeNs = 0;         // thread CPU time spent in the codec
+
+    /* Uncompressed size over compressed size, 0 if nothing compressed */
+    double getRatio() const
+    {
+        return compressedBytes ? (double)uncompressedBytes / (double)compressedBytes : 0;
+    }
+};
+
+class ZmqCompressor
+{
+public:
+    /* Bit mask of the codecs this library supports */
+    static uint8_t supportedCodecs();
+
+    static bool isSupported(uint8_t codecs, ZmqCompression codec);
+
+    /* Buffer size compress() needs at most */
+    static size_t compressBound(ZmqCompression codec, size_t size);
+
+    /*
+     * Compress data into output, prefixed with the uncompressed size.
+     * Return the compressed size, 0 when the data doesn't shrink and
+     * should be sent as is.
+     */
+    static size_t compress(ZmqCompression codec, const char* data, size_t size, char* output, size_t capacity, ZmqCompressionStats& stats);
+
+    /* Uncompressed size of a message of compress(), throw if it is invalid */
+    static size_t decompressedSize(const char* data, size_t size);
+
+    /* Decompress a message of compress() into output of decompressedSize() bytes, throw if it is corrupted */
+    static void decompress(ZmqCompression codec, const char* data, size_t size, char* output, size_t outputSize, ZmqCompressionStats& stats);
+};
+
+}
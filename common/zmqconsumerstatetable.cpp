@@ -51,64 +51,119 @@ ZmqConsumerStateTable::ZmqConsumerStateTable(DBConnector *db, const std::string
 
 void ZmqConsumerStateTable::handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &kcos)
 {
-    for (auto kco : kcos)
+    // The caller keeps the tuples, copy them out of the lock
+    std::deque<KeyOpFieldsValuesTuple> copies;
+    for (auto &kco : kcos)
     {
-        std::shared_ptr<KeyOpFieldsValuesTuple> clone = nullptr;
-        if (m_asyncDBUpdater != nullptr)
-        {
-            // clone before put to received queue, because received data may change by consumer.
-            clone = std::make_shared<KeyOpFieldsValuesTuple>(*kco);
-        }
+        copies.push_back(*kco);
+    }
 
-        {
-            std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
-            m_receivedOperationQueue.push(kco);
-        }
+    {
+        std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
+        m_receivedOperationQueue.insert(m_receivedOperationQueue.end(),
+                                        std::make_move_iterator(copies.begin()),
+                                        std::make_move_iterator(copies.end()));
+    }
+
+    if (m_asyncDBUpdater != nullptr)
+    {
+        m_asyncDBUpdater->update(kcos);
+    }
 
-        if (m_asyncDBUpdater != nullptr)
+    m_selectableEvent.notify(); // will release epoll
+}
+
+bool ZmqConsumerStateTable::handleReceivedMessage(std::shared_ptr<const KcoViewMessage> message)
+{
+    // Build the tuples straight from the receive buffer views, out of the lock
+    std::deque<KeyOpFieldsValuesTuple> kcos;
+    for (auto &kco : message->kcos)
+    {
+        kcos.push_back(kco.toKco());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
+        // The request is handled once the consumer pops its operations
+        if (!message->clientId.empty())
         {
-            m_asyncDBUpdater->update(clone);
+            m_receivedRequests.push_back(ReceivedRequest{message->clientId, message->requestId, kcos.size()});
         }
+        m_receivedOperationQueue.insert(m_receivedOperationQueue.end(),
+                                        std::make_move_iterator(kcos.begin()),
+                                        std::make_move_iterator(kcos.end()));
+    }
+
+    if (m_asyncDBUpdater != nullptr)
+    {
+        // The updater writes from the receive buffer, the tuples are only built for the consumer
+        m_asyncDBUpdater->update(message);
     }
+
     m_selectableEvent.notify(); // will release epoll
+    return false;
+}
+
+void ZmqConsumerStateTable::setPoppedRequestsHandled(size_t popped)
+{
+    while (!m_popRequests.empty() && m_popRequests.front().count <= popped)
+    {
+        auto& request = m_popRequests.front();
+        popped -= request.count;
+        m_zmqServer.setRequestHandled(m_db->getDbName(), getTableName(), request.clientId, request.requestId);
+        m_popRequests.pop_front();
+    }
+
+    if (!m_popRequests.empty())
+    {
+        m_popRequests.front().count -= popped;
+    }
 }
 
 /* Get multiple pop elements */
 void ZmqConsumerStateTable::pops(std::deque<KeyOpFieldsValuesTuple> &vkco, const std::string& /*prefix*/)
 {
-    size_t count;
+    if (m_popQueue.empty())
     {
-        // size() is not thread safe
+        // Take everything received so far, new data appended during pops
+        // will be taken by the next swap.
         std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
-
-        // For new data append to m_dataQueue during pops, will not be include in result.
-        count = m_receivedOperationQueue.size();
-        if (!count)
-        {
-            return;
-        }
+        m_popQueue.swap(m_receivedOperationQueue);
+        m_popRequests.swap(m_receivedRequests);
     }
 
-    vkco.clear();
-    auto pop_limit = min(count, m_popBatchSize);
-    for (size_t ie = 0; ie < pop_limit; ie++)
+    if (m_popQueue.empty())
     {
-        auto& kco = *(m_receivedOperationQueue.front());
-        vkco.push_back(std::move(kco));
-
-        {
-            std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
-            m_receivedOperationQueue.pop();
-        }
+        // requests without operation
+        setPoppedRequestsHandled(0);
+        return;
     }
 
-    if (count > m_popBatchSize)
+    vkco.clear();
+    auto pop_limit = min(m_popQueue.size(), m_popBatchSize);
+    auto end = m_popQueue.begin() + static_cast<ptrdiff_t>(pop_limit);
+    vkco.insert(vkco.end(), std::make_move_iterator(m_popQueue.begin()), std::make_move_iterator(end));
+    m_popQueue.erase(m_popQueue.begin(), end);
+    setPoppedRequestsHandled(pop_limit);
+
+    if (!m_popQueue.empty())
     {
         // Notify epoll to wake up and continue to pop.
         m_selectableEvent.notify();
     }
 }
 
+void ZmqConsumerStateTable::setDbUpdaterMaxQueueSize(size_t maxQueueSize)
+{
+    if (m_asyncDBUpdater == nullptr)
+    {
+        throw system_error(make_error_code(errc::operation_not_supported),
+                           "Database persistence is not enabled");
+    }
+
+    m_asyncDBUpdater->setMaxQueueSize(maxQueueSize);
+}
+
 size_t ZmqConsumerStateTable::dbUpdaterQueueSize()
 {
     if (m_asyncDBUpdater == nullptr)
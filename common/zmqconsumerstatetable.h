@@ -2,7 +2,6 @@
 
 #include <string>
 #include <deque>
-#include <list>
 #include <condition_variable>
 #include "asyncdbupdater.h"
 #include "consumertablebase.h"
@@ -46,6 +45,11 @@ public:
     */
     bool hasData() override
     {
+        if (!m_popQueue.empty())
+        {
+            return true;
+        }
+
         std::lock_guard<std::mutex> lock(m_receivedQueueMutex);
         return !m_receivedOperationQueue.empty();
     }
@@ -70,12 +74,45 @@ public:
 
     size_t dbUpdaterQueueSize();
 
+    /*
+     * Bound the updates waiting for the DB write back, receiving blocks
+     * while it is full, which pushes back on the ZMQ clients. 0 is unbounded.
+     */
+    void setDbUpdaterMaxQueueSize(size_t maxQueueSize);
+
 private:
-    void handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &kcos);
+    void handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> &kcos) override;
+
+    bool handleReceivedMessage(std::shared_ptr<const KcoViewMessage> message) override;
+
+    /* A received request and its operations not popped yet */
+    struct ReceivedRequest
+    {
+        std::string clientId;
+        uint64_t requestId;
+        size_t count;
+    };
 
+    /* Mark the requests of the popped operations as handled, so ZmqServer responds to them */
+    void setPoppedRequestsHandled(size_t popped);
+
+    /*
+     * The ZMQ poll thread appends every received batch to
+     * m_receivedOperationQueue with a single lock, and pops() swaps the
+     * whole queue into m_popQueue with a single lock when m_popQueue is
+     * drained, so the two threads synchronize once per batch instead of
+     * once per operation. m_popQueue is only accessed by the consumer.
+     */
     std::mutex m_receivedQueueMutex;
 
-    std::queue<std::shared_ptr<KeyOpFieldsValuesTuple>, std::list<std::shared_ptr<KeyOpFieldsValuesTuple>>> m_receivedOperationQueue;
+    std::deque<KeyOpFieldsValuesTuple> m_receivedOperationQueue;
+
+    std::deque<KeyOpFieldsValuesTuple> m_popQueue;
+
+    // The requests of m_receivedOperationQueue and m_popQueue, in order
+    std::deque<ReceivedRequest> m_receivedRequests;
+
+    std::deque<ReceivedRequest> m_popRequests;
 
     swss::SelectableEvent m_selectableEvent;
 
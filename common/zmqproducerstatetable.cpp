@@ -164,6 +164,11 @@ void ZmqProducerStateTable::send(const std::vector<KeyOpFieldsValuesTuple> &kcos
     }
 }
 
+void ZmqProducerStateTable::apply(const std::vector<KeyOpFieldsValuesTuple> &values)
+{
+    send(values);
+}
+
 bool ZmqProducerStateTable::wait(const std::string& dbName,
               const std::string& tableName,
               const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos)
@@ -171,6 +176,13 @@ bool ZmqProducerStateTable::wait(const std::string& dbName,
     return m_zmqClient.wait(dbName, tableName, kcos);
 }
 
+bool ZmqProducerStateTable::wait(std::string& dbName,
+              std::string& tableName,
+              std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos)
+{
+    return m_zmqClient.wait(dbName, tableName, kcos);
+}
+
 size_t ZmqProducerStateTable::dbUpdaterQueueSize()
 {
     if (m_asyncDBUpdater == nullptr)
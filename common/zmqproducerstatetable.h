@@ -37,11 +37,19 @@ public:
     // Batched send that can include both SET and DEL requests.
     virtual void send(const std::vector<KeyOpFieldsValuesTuple> &kcos);
 
+    // Same as send(), one message keeps the SET and DEL requests in order.
+    virtual void apply(const std::vector<KeyOpFieldsValuesTuple> &values);
+
     // To wait for the response from the peer.
     virtual bool wait(const std::string& dbName,
               const std::string& tableName,
               const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos);
 
+    // Same as above, return the response.
+    virtual bool wait(std::string& dbName,
+              std::string& tableName,
+              std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos);
+
     size_t dbUpdaterQueueSize();
 private:
     void initialize(DBConnector *db, const std::string &tableName, bool dbPersistence);
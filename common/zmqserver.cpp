@@ -1,17 +1,142 @@
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
 #include <string>
+#include <cstring>
 #include <deque>
 #include <limits>
+#include <cinttypes>
+#include <algorithm>
 #include <hiredis/hiredis.h>
 #include <zmq.h>
 #include <pthread.h>
 #include "zmqserver.h"
 #include "binaryserializer.h"
+#include "zmqshm.h"
 
 using namespace std;
 
 namespace swss {
 
+bool ZmqMessageHandler::handleReceivedMessage(std::shared_ptr<const KcoViewMessage> message)
+{
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    kcos.reserve(message->kcos.size());
+    for (auto& kco : message->kcos)
+    {
+        kcos.push_back(std::make_shared<KeyOpFieldsValuesTuple>(kco.toKco()));
+    }
+
+    handleReceivedData(kcos);
+    return true;
+}
+
+static std::shared_ptr<zmq_msg_t> decompressMessage(ZmqCompression codec, zmq_msg_t& compressed, ZmqCompressionStats& stats)
+{
+    if (!ZmqCompressor::isSupported(ZmqCompressor::supportedCodecs(), codec))
+    {
+        SWSS_LOG_THROW("unsupported codec %u", static_cast<unsigned>(codec));
+    }
+
+    auto data = static_cast<const char*>(zmq_msg_data(&compressed));
+    auto size = zmq_msg_size(&compressed);
+    auto rawSize = ZmqCompressor::decompressedSize(data, size);
+
+    std::shared_ptr<zmq_msg_t> msg(new zmq_msg_t, [](zmq_msg_t *m) {
+        zmq_msg_close(m);
+        delete m;
+    });
+    if (zmq_msg_init_size(msg.get(), rawSize) != 0)
+    {
+        // the deleter must not close a message that failed to init
+        zmq_msg_init(msg.get());
+        SWSS_LOG_THROW("failed to allocate %zu bytes, zmqerrno: %d", rawSize, zmq_errno());
+    }
+
+    ZmqCompressor::decompress(codec, data, size, static_cast<char*>(zmq_msg_data(msg.get())), rawSize, stats);
+    return msg;
+}
+
+/* Handles the messages of the tables assigned to it, in receive order */
+class ZmqServer::DispatchWorker
+{
+public:
+    DispatchWorker(ZmqServer& server)
+        : m_server(server),
+        m_running(true)
+    {
+        m_thread = std::make_shared<std::thread>(&DispatchWorker::run, this);
+    }
+
+    ~DispatchWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cv.notify_all();
+        m_thread->join();
+    }
+
+    void post(ZmqMessageHandler* handler, const char* data, size_t size, std::shared_ptr<const void> owner,
+              const BinaryStringView& clientId, uint64_t requestId)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(Task{handler, data, size, std::move(owner), clientId.str(), requestId});
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    struct Task
+    {
+        ZmqMessageHandler* handler;
+        const char* data;
+        size_t size;
+        std::shared_ptr<const void> owner;
+        std::string clientId;
+        uint64_t requestId;
+    };
+
+    void run()
+    {
+        std::deque<Task> tasks;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return !m_tasks.empty() || !m_running; });
+                if (m_tasks.empty())
+                {
+                    break;
+                }
+                tasks.swap(m_tasks);
+            }
+
+            for (auto& task : tasks)
+            {
+                try
+                {
+                    m_server.handleReceivedData(task.handler, task.data, task.size, task.owner, task.clientId, task.requestId);
+                }
+                catch (const std::exception& e)
+                {
+                    SWSS_LOG_ERROR("ZmqServer dispatch worker failed to handle message: %s", e.what());
+                }
+            }
+            tasks.clear();
+        }
+    }
+
+    ZmqServer& m_server;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Task> m_tasks;
+    bool m_running;
+    std::shared_ptr<std::thread> m_thread;
+};
+
 ZmqServer::ZmqServer(const std::string& endpoint)
     : ZmqServer(endpoint, "", false)
 {
@@ -22,13 +147,28 @@ ZmqServer::ZmqServer(const std::string& endpoint, const std::string& vrf)
 {
 }
 
-ZmqServer::ZmqServer(const std::string& endpoint, const std::string& vrf, bool lazyBind)
+ZmqServer::ZmqServer(const std::string& endpoint, const std::string& vrf, bool lazyBind, size_t dispatchThreads, bool enableResponse)
     : m_mqPollThread(nullptr),
     m_endpoint(endpoint),
     m_vrf(vrf),
     m_context(nullptr),
-    m_socket(nullptr)
+    m_socket(nullptr),
+    m_enableResponse(enableResponse),
+    m_nextWorker(0),
+    m_shmListener(-1),
+    m_nextShmClient(0)
 {
+    m_responseEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_responseEvent < 0)
+    {
+        SWSS_LOG_THROW("ZmqServer failed to create eventfd, errno: %d", errno);
+    }
+
+    for (size_t i = 0; i < dispatchThreads; i++)
+    {
+        m_workers.emplace_back(new DispatchWorker(*this));
+    }
+
     if (!lazyBind)
     {
         bind();
@@ -45,6 +185,9 @@ ZmqServer::~ZmqServer()
         m_mqPollThread->join();
     }
 
+    // handle the messages already received before closing
+    m_workers.clear();
+
     if (m_socket)
     {
         zmq_close(m_socket);
@@ -54,18 +197,45 @@ ZmqServer::~ZmqServer()
     {
         zmq_ctx_destroy(m_context);
     }
+
+    for (auto& client : m_shmClients)
+    {
+        close(client->sock);
+    }
+    m_shmClients.clear();
+
+    if (m_shmListener >= 0)
+    {
+        close(m_shmListener);
+        unlink(m_shmPath.c_str());
+    }
+
+    close(m_responseEvent);
 }
 
 void ZmqServer::bind()
 {
     SWSS_LOG_ENTER();
-    if (m_socket)
+    if (m_socket || m_shmListener >= 0)
     {
         SWSS_LOG_THROW("ZmqServer has already been bound to the endpoint: %s", m_endpoint.c_str());
     }
 
+    if (m_endpoint.compare(0, strlen(MQ_SHM_ENDPOINT_PREFIX), MQ_SHM_ENDPOINT_PREFIX) == 0)
+    {
+        // Same host clients hand over a shared memory ring through a unix socket
+        m_shmPath = m_endpoint.substr(strlen(MQ_SHM_ENDPOINT_PREFIX));
+        m_shmListener = ShmConnection::listen(m_shmPath);
+        SWSS_LOG_DEBUG("ZmqServer listen on shared memory endpoint: %s", m_endpoint.c_str());
+
+        startMqPollThread();
+        return;
+    }
+
+    // ZMQ Client/Server are n:1 mapping, the ROUTER of the response path
+    // routes the responses back to the DEALER clients: http://api.zeromq.org/master:zmq-socket
     m_context = zmq_ctx_new();
-    m_socket = zmq_socket(m_context, ZMQ_PULL);
+    m_socket = zmq_socket(m_context, m_enableResponse ? ZMQ_ROUTER : ZMQ_PULL);
 
     // Increase recv buffer for use all bandwidth:  http://api.zeromq.org/4-2:zmq-setsockopt
     int high_watermark = MQ_WATERMARK;
@@ -94,56 +264,118 @@ void ZmqServer::registerMessageHandler(
                                     const std::string tableName,
                                     ZmqMessageHandler* handler)
 {
-    auto dbResult = m_HandlerMap.insert(pair<string, map<string, ZmqMessageHandler*>>(dbName, map<string, ZmqMessageHandler*>()));
-    if (dbResult.second) {
-        SWSS_LOG_DEBUG("ZmqServer add handler mapping for db: %s", dbName.c_str());
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    auto& entries = m_handlerMap[getTableId(dbName.data(), dbName.size(), tableName.data(), tableName.size())];
+    for (auto& entry : entries)
+    {
+        if (entry.dbName == dbName && entry.tableName == tableName)
+        {
+            return;
+        }
     }
 
-    auto tableResult = dbResult.first->second.insert(pair<string, ZmqMessageHandler*>(tableName, handler));
-    if (tableResult.second) {
-        SWSS_LOG_DEBUG("ZmqServer register handler for db: %s, table: %s", dbName.c_str(), tableName.c_str());
+    // Spread the tables over the workers, every table stays on one worker
+    size_t worker = 0;
+    if (!m_workers.empty())
+    {
+        worker = m_nextWorker++ % m_workers.size();
     }
+
+    entries.push_back(HandlerEntry{dbName, tableName, handler, worker, {}});
+    SWSS_LOG_DEBUG("ZmqServer register handler for db: %s, table: %s", dbName.c_str(), tableName.c_str());
 }
 
-ZmqMessageHandler* ZmqServer::findMessageHandler(
-                                                const std::string dbName,
-                                                const std::string tableName)
+uint64_t ZmqServer::getTableId(const char* dbName, size_t dbNameLen, const char* tableName, size_t tableNameLen)
 {
-    auto dbMappingIter = m_HandlerMap.find(dbName);
-    if (dbMappingIter == m_HandlerMap.end()) {
-        SWSS_LOG_DEBUG("ZmqServer can't find any handler for db: %s", dbName.c_str());
-        return nullptr;
+    // FNV-1a over the DB name, a separator and the table name
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(dbName, dbNameLen);
+    mix("", 1);
+    mix(tableName, tableNameLen);
+    return hash;
+}
+
+ZmqServer::HandlerEntry* ZmqServer::findHandlerEntry(const BinaryStringView& dbName, const BinaryStringView& tableName)
+{
+    auto iter = m_handlerMap.find(getTableId(dbName.data, dbName.size, tableName.data, tableName.size));
+    if (iter != m_handlerMap.end())
+    {
+        for (auto& entry : iter->second)
+        {
+            if (dbName == entry.dbName && tableName == entry.tableName)
+            {
+                return &entry;
+            }
+        }
     }
 
-    auto tableMappingIter = dbMappingIter->second.find(tableName);
-    if (tableMappingIter == dbMappingIter->second.end()) {
-        SWSS_LOG_DEBUG("ZmqServer can't find handler for db: %s, table: %s", dbName.c_str(), tableName.c_str());
+    return nullptr;
+}
+
+ZmqMessageHandler* ZmqServer::findMessageHandler(
+                                const BinaryStringView& dbName,
+                                const BinaryStringView& tableName,
+                                size_t& worker)
+{
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    auto entry = findHandlerEntry(dbName, tableName);
+    if (entry == nullptr)
+    {
         return nullptr;
     }
 
-    return tableMappingIter->second;
+    worker = entry->worker;
+    return entry->handler;
 }
 
-void ZmqServer::handleReceivedData(const char* buffer, const size_t size)
+void ZmqServer::handleReceivedData(ZmqMessageHandler* handler, const char* buffer, const size_t size, std::shared_ptr<const void> owner,
+                                   const std::string& clientId, uint64_t requestId)
 {
-    std::string dbName;
-    std::string tableName;
-    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
-    BinarySerializer::deserializeBuffer(buffer, size, dbName, tableName, kcos);
+    auto message = std::make_shared<KcoViewMessage>();
+    message->owner = owner;
+    message->clientId = clientId;
+    message->requestId = requestId;
+    BinarySerializer::deserializeBuffer(buffer, size, *message);
+
+    if (handler->handleReceivedMessage(message))
+    {
+        setRequestHandled(message->dbName, message->tableName, clientId, requestId);
+    }
+}
+
+void ZmqServer::setRequestHandled(const std::string& dbName, const std::string& tableName,
+                                  const std::string& clientId, uint64_t requestId)
+{
+    setRequestHandled(BinaryStringView{dbName.data(), dbName.size()}, BinaryStringView{tableName.data(), tableName.size()}, clientId, requestId);
+}
 
-    // find handler
-    auto handler = findMessageHandler(dbName, tableName);
-    if (handler == nullptr) {
-        SWSS_LOG_WARN("ZmqServer can't find handler for received message: %s", buffer);
+void ZmqServer::setRequestHandled(const BinaryStringView& dbName, const BinaryStringView& tableName,
+                                  const std::string& clientId, uint64_t requestId)
+{
+    // a PUSH client can't be responded
+    if (clientId.empty())
+    {
         return;
     }
 
-    handler->handleReceivedData(kcos);
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    auto entry = findHandlerEntry(dbName, tableName);
+    if (entry != nullptr)
+    {
+        auto& handled = entry->handledRequests[clientId];
+        handled = std::max(handled, requestId);
+    }
 }
 
 void ZmqServer::startMqPollThread()
 {
-    m_buffer.resize(MQ_RESPONSE_MAX_COUNT);
     m_runThread = true;
     m_mqPollThread = std::make_shared<std::thread>(&ZmqServer::mqPollThread, this);
 }
@@ -153,62 +385,539 @@ void ZmqServer::mqPollThread()
     SWSS_LOG_ENTER();
     SWSS_LOG_NOTICE("mqPollThread begin");
 
-    // zmq_poll will use less CPU
-    zmq_pollitem_t poll_item;
-    poll_item.fd = 0;
-    poll_item.socket = m_socket;
-    poll_item.events = ZMQ_POLLIN;
-    poll_item.revents = 0;
+    // zmq_poll will use less CPU, the eventfd wakes it up for the queued responses
+    std::vector<zmq_pollitem_t> poll_items;
+    auto addPollItem = [&poll_items](void* socket, int fd) {
+        zmq_pollitem_t item;
+        item.socket = socket;
+        item.fd = fd;
+        item.events = ZMQ_POLLIN;
+        item.revents = 0;
+        poll_items.push_back(item);
+        return poll_items.size() - 1;
+    };
+    // poll item of the socket of every shared memory client
+    std::vector<size_t> shmItems;
 
     SWSS_LOG_NOTICE("bind to zmq endpoint: %s", m_endpoint.c_str());
     while (m_runThread)
     {
-        // receive message
-        auto rc = zmq_poll(&poll_item, 1, 1000);
-        if (rc == 0 || !(poll_item.revents & ZMQ_POLLIN))
+        // Drain the shared memory rings before sleeping on their events
+        long timeout = 1000;
+        for (auto& client : m_shmClients)
         {
-            // timeout or other event
-            SWSS_LOG_DEBUG("zmq_poll timeout or invalied event rc: %d, revents: %d", rc, poll_item.revents);
-            continue;
+            if (client->ring)
+            {
+                recvShmMessages(*client);
+                if (!client->ring->prepareWait())
+                {
+                    timeout = 0;
+                }
+            }
+        }
+
+        poll_items.clear();
+        size_t responseItem = addPollItem(nullptr, m_responseEvent);
+        size_t socketItem = m_socket ? addPollItem(m_socket, 0) : SIZE_MAX;
+        size_t listenerItem = m_shmListener >= 0 ? addPollItem(nullptr, m_shmListener) : SIZE_MAX;
+        shmItems.clear();
+        for (auto& client : m_shmClients)
+        {
+            shmItems.push_back(addPollItem(nullptr, client->sock));
+            if (!client->output.empty())
+            {
+                poll_items.back().events |= ZMQ_POLLOUT;
+            }
+            if (client->ring)
+            {
+                addPollItem(nullptr, client->ring->getDataEvent());
+            }
         }
 
         // receive message
-        rc = zmq_recv(m_socket, m_buffer.data(), MQ_RESPONSE_MAX_COUNT, ZMQ_DONTWAIT);
+        auto rc = zmq_poll(poll_items.data(), static_cast<int>(poll_items.size()), timeout);
+        for (auto& client : m_shmClients)
+        {
+            if (client->ring)
+            {
+                client->ring->finishWait();
+            }
+        }
+
         if (rc < 0)
         {
-            int zmq_err = zmq_errno();
-            SWSS_LOG_DEBUG("zmq_recv failed, endpoint: %s,zmqerrno: %d", m_endpoint.c_str(), zmq_err);
-            if (zmq_err == EINTR || zmq_err == EAGAIN)
+            SWSS_LOG_DEBUG("zmq_poll failed, zmqerrno: %d", zmq_errno());
+            continue;
+        }
+
+        if (poll_items[responseItem].revents & ZMQ_POLLIN)
+        {
+            uint64_t count;
+            if (read(m_responseEvent, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            {
+                SWSS_LOG_WARN("ZmqServer failed to read eventfd, errno: %d", errno);
+            }
+            sendResponses();
+        }
+
+        // A shared memory client writes its ring to its socket, then only closes it
+        for (size_t i = 0; i < m_shmClients.size(); i++)
+        {
+            auto revents = poll_items[shmItems[i]].revents;
+            if (revents & ZMQ_POLLOUT)
+            {
+                flushShmOutput(*m_shmClients[i]);
+            }
+
+            if (!m_shmClients[i]->ring && (revents & ZMQ_POLLIN) && recvShmRing(*m_shmClients[i]))
             {
                 continue;
             }
-            else
+
+            if (revents & (ZMQ_POLLIN | ZMQ_POLLERR))
             {
-                SWSS_LOG_THROW("zmq_recv failed, endpoint: %s,zmqerrno: %d", m_endpoint.c_str(), zmq_err);
+                if (m_shmClients[i]->ring)
+                {
+                    recvShmMessages(*m_shmClients[i]);
+                }
+                SWSS_LOG_NOTICE("ZmqServer shared memory client %s disconnected", m_shmClients[i]->clientId.c_str());
+                close(m_shmClients[i]->sock);
+                m_shmClients[i].reset();
             }
         }
+        m_shmClients.erase(std::remove(m_shmClients.begin(), m_shmClients.end(), nullptr), m_shmClients.end());
+
+        if (listenerItem != SIZE_MAX && (poll_items[listenerItem].revents & ZMQ_POLLIN))
+        {
+            acceptShmClient();
+        }
+
+        if (socketItem != SIZE_MAX && (poll_items[socketItem].revents & ZMQ_POLLIN))
+        {
+            recvZmqMessage();
+        }
+    }
+
+    SWSS_LOG_NOTICE("mqPollThread end");
+}
+
+void ZmqServer::recvZmqMessage()
+{
+    // A request is the routing id of the client on ROUTER, the request id
+    // and the payload, PUSH clients only send the payload.
+    // The payload is owned by the handlers that keep a view of it.
+    zmq_msg_t clientId;
+    zmq_msg_t requestIdFrame;
+    std::shared_ptr<zmq_msg_t> msg(new zmq_msg_t, [](zmq_msg_t *m) {
+        zmq_msg_close(m);
+        delete m;
+    });
+    zmq_msg_init(&clientId);
+    zmq_msg_init(&requestIdFrame);
+    zmq_msg_init(msg.get());
+    zmq_msg_t* frames[] = { &clientId, &requestIdFrame, msg.get() };
+    size_t frameCount = m_enableResponse ? 0 : 1;
+    int more = 1;
+    int rc = 0;
+    while (more)
+    {
+        // unexpected extra frames overwrite the payload and are dropped below
+        auto frame = frames[std::min<size_t>(frameCount, 2)];
+        if (frameCount > 2)
+        {
+            zmq_msg_close(frame);
+            zmq_msg_init(frame);
+        }
 
-        if (rc >= MQ_RESPONSE_MAX_COUNT)
+        rc = zmq_msg_recv(frame, m_socket, ZMQ_DONTWAIT);
+        if (rc < 0)
         {
-            SWSS_LOG_THROW("zmq_recv message was truncated (over %d bytes, received %d), increase buffer size, message DROPPED",
-                    MQ_RESPONSE_MAX_COUNT,
-                    rc);
+            break;
         }
 
-        m_buffer.at(rc) = 0; // make sure that we end string with zero before parse
-        SWSS_LOG_DEBUG("zmq received %d bytes", rc);
+        more = zmq_msg_more(frame);
+        frameCount++;
+    }
 
+    if (rc < 0)
+    {
+        zmq_msg_close(&clientId);
+        zmq_msg_close(&requestIdFrame);
+        int zmq_err = zmq_errno();
+        SWSS_LOG_DEBUG("zmq_recv failed, endpoint: %s,zmqerrno: %d", m_endpoint.c_str(), zmq_err);
+        if (zmq_err == EINTR || zmq_err == EAGAIN)
+        {
+            return;
+        }
+        else
+        {
+            SWSS_LOG_THROW("zmq_recv failed, endpoint: %s,zmqerrno: %d", m_endpoint.c_str(), zmq_err);
+        }
+    }
+
+    uint64_t requestId = 0;
+    uint8_t codec = static_cast<uint8_t>(ZmqCompression::NONE);
+    auto requestIdSize = zmq_msg_size(&requestIdFrame);
+    if (frameCount == 2)
+    {
+        // no request id, the payload is in the second frame
+        zmq_msg_move(msg.get(), &requestIdFrame);
+    }
+    else if (frameCount == 3 && (requestIdSize == sizeof(requestId) || requestIdSize == sizeof(requestId) + 1))
+    {
+        auto requestIdData = static_cast<const char*>(zmq_msg_data(&requestIdFrame));
+        memcpy(&requestId, requestIdData, sizeof(requestId));
+        if (requestIdSize > sizeof(requestId))
+        {
+            codec = static_cast<uint8_t>(requestIdData[sizeof(requestId)]);
+        }
+    }
+    else
+    {
+        SWSS_LOG_WARN("ZmqServer dropped malformed message with %zu frames, endpoint: %s", frameCount, m_endpoint.c_str());
+        zmq_msg_close(&clientId);
+        zmq_msg_close(&requestIdFrame);
+        return;
+    }
+
+    if (codec == MQ_CODEC_PROBE && !m_enableResponse)
+    {
+        SWSS_LOG_WARN("ZmqServer can't answer codec probe without response path, endpoint: %s", m_endpoint.c_str());
+        zmq_msg_close(&clientId);
+        zmq_msg_close(&requestIdFrame);
+        return;
+    }
+    else if (codec == MQ_CODEC_PROBE)
+    {
+        // answer with the codecs both sides support and the wire formats
+        uint8_t answer[2] = { 0, MQ_PROBE_FORMAT_V2 };
+        if (zmq_msg_size(msg.get()) == sizeof(answer[0]))
+        {
+            answer[0] = *static_cast<const uint8_t*>(zmq_msg_data(msg.get())) & ZmqCompressor::supportedCodecs();
+        }
+        if (zmq_send(m_socket, zmq_msg_data(&clientId), zmq_msg_size(&clientId), ZMQ_DONTWAIT | ZMQ_SNDMORE) < 0
+            || zmq_send(m_socket, zmq_msg_data(&requestIdFrame), requestIdSize, ZMQ_DONTWAIT | ZMQ_SNDMORE) < 0
+            || zmq_send(m_socket, answer, sizeof(answer), ZMQ_DONTWAIT) < 0)
+        {
+            SWSS_LOG_WARN("ZmqServer failed to answer codec probe, endpoint: %s, zmqerrno: %d", m_endpoint.c_str(), zmq_errno());
+        }
+        zmq_msg_close(&clientId);
+        zmq_msg_close(&requestIdFrame);
+        return;
+    }
+    zmq_msg_close(&requestIdFrame);
+
+    if (codec != static_cast<uint8_t>(ZmqCompression::NONE))
+    {
+        ZmqCompressionStats stats;
+        try
+        {
+            msg = decompressMessage(static_cast<ZmqCompression>(codec), *msg, stats);
+        }
+        catch (const std::exception& e)
+        {
+            SWSS_LOG_WARN("ZmqServer dropped request %" PRIu64 ", endpoint: %s: %s", requestId, m_endpoint.c_str(), e.what());
+            zmq_msg_close(&clientId);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_compressionStats.messages += stats.messages;
+        m_compressionStats.uncompressedBytes += stats.uncompressedBytes;
+        m_compressionStats.compressedBytes += stats.compressedBytes;
+        m_compressionStats.cpuTimeNs += stats.cpuTimeNs;
+    }
+
+    SWSS_LOG_DEBUG("zmq received request %" PRIu64 ", %zu bytes", requestId, zmq_msg_size(msg.get()));
+
+    // an empty client id means there is no response path
+    BinaryStringView client{static_cast<const char*>(zmq_msg_data(&clientId)), zmq_msg_size(&clientId)};
+    dispatchMessage(client, requestId, static_cast<const char*>(zmq_msg_data(msg.get())), zmq_msg_size(msg.get()), msg);
+    zmq_msg_close(&clientId);
+}
+
+void ZmqServer::dispatchMessage(const BinaryStringView& clientId, uint64_t requestId, const char* data, size_t size, std::shared_ptr<const void> owner)
+{
+    // only peek the table, the message is decoded by its handler thread
+    BinaryStringView dbName, tableName;
+    try
+    {
+        BinarySerializer::deserializeHeader(data, size, dbName, tableName);
+    }
+    catch (const std::exception& e)
+    {
+        SWSS_LOG_WARN("ZmqServer dropped malformed request %" PRIu64 ", endpoint: %s: %s", requestId, m_endpoint.c_str(), e.what());
+        return;
+    }
+
+    size_t worker = 0;
+    auto handler = findMessageHandler(dbName, tableName, worker);
+    if (handler == nullptr)
+    {
+        SWSS_LOG_WARN("ZmqServer can't find handler for received message, db: %s, table: %s", dbName.str().c_str(), tableName.str().c_str());
+        return;
+    }
+
+    if (m_workers.empty())
+    {
         // deserialize and write to redis:
-        handleReceivedData(m_buffer.data(), rc);
+        handleReceivedData(handler, data, size, owner, clientId.str(), requestId);
     }
-    SWSS_LOG_NOTICE("mqPollThread end");
+    else
+    {
+        m_workers[worker]->post(handler, data, size, std::move(owner), clientId, requestId);
+    }
+}
+
+void ZmqServer::acceptShmClient()
+{
+    int sock = accept4(m_shmListener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (sock < 0)
+    {
+        SWSS_LOG_WARN("ZmqServer failed to accept shared memory client, endpoint: %s, errno: %d", m_endpoint.c_str(), errno);
+        return;
+    }
+
+    // The ring is received once the socket is readable, not to block the receive thread
+    std::unique_ptr<ShmClient> client(new ShmClient);
+    client->sock = sock;
+    client->clientId = "shm:" + std::to_string(m_nextShmClient++);
+    m_shmClients.push_back(std::move(client));
+}
+
+bool ZmqServer::recvShmRing(ShmClient& client)
+{
+    try
+    {
+        client.ring = ShmConnection::recvRing(client.sock);
+    }
+    catch (const std::exception& e)
+    {
+        // the client is dropped with its socket
+        SWSS_LOG_WARN("ZmqServer rejected shared memory client %s, endpoint: %s: %s", client.clientId.c_str(), m_endpoint.c_str(), e.what());
+        return false;
+    }
+
+    SWSS_LOG_NOTICE("ZmqServer shared memory client %s connected, ring size: %zu", client.clientId.c_str(), client.ring->getCapacity());
+    return true;
+}
+
+void ZmqServer::recvShmMessages(ShmClient& client)
+{
+    // A message is the request id and the payload, copied out of the ring
+    // so the handlers can keep it while the ring is reused.
+    const char* data;
+    size_t size;
+    try
+    {
+        while (client.ring->front(data, size))
+        {
+            if (size >= sizeof(uint64_t))
+            {
+                uint64_t requestId;
+                memcpy(&requestId, data, sizeof(requestId));
+                size -= sizeof(requestId);
+
+                std::shared_ptr<char> payload(new char[size], std::default_delete<char[]>());
+                memcpy(payload.get(), data + sizeof(requestId), size);
+                client.ring->pop();
+
+                BinaryStringView clientId{client.clientId.data(), client.clientId.size()};
+                dispatchMessage(clientId, requestId, payload.get(), size, payload);
+            }
+            else
+            {
+                SWSS_LOG_WARN("ZmqServer dropped malformed message of %zu bytes, client: %s", size, client.clientId.c_str());
+                client.ring->pop();
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        // a corrupted ring can't be read any more, drop the client
+        SWSS_LOG_ERROR("ZmqServer failed to read shared memory client %s: %s", client.clientId.c_str(), e.what());
+        shutdown(client.sock, SHUT_RDWR);
+    }
+}
+
+void ZmqServer::sendMsg(
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<swss::KeyOpFieldsValuesTuple>& values)
+{
+    std::vector<std::pair<std::string, uint64_t>> requests;
+    {
+        std::lock_guard<std::mutex> lock(m_handlerMutex);
+        auto entry = findHandlerEntry(BinaryStringView{dbName.data(), dbName.size()}, BinaryStringView{tableName.data(), tableName.size()});
+        if (entry != nullptr)
+        {
+            requests.assign(entry->handledRequests.begin(), entry->handledRequests.end());
+            entry->handledRequests.clear();
+        }
+    }
+
+    if (requests.empty())
+    {
+        SWSS_LOG_DEBUG("ZmqServer has no handled request to respond, db: %s, table: %s", dbName.c_str(), tableName.c_str());
+        return;
+    }
+
+    queueResponses(requests, dbName, tableName, values);
 }
 
-// TODO: To be implemented later, required for ZMQ_CLIENT & ZMQ_SERVER
-// socket types in response path.
 void ZmqServer::sendMsg(
-    const std::string &dbName, const std::string &tableName,
-    const std::vector<swss::KeyOpFieldsValuesTuple> &values) {
-  return;
+        const KcoViewMessage& request,
+        const std::vector<swss::KeyOpFieldsValuesTuple>& values)
+{
+    if (request.clientId.empty())
+    {
+        SWSS_LOG_DEBUG("ZmqServer can't respond request %" PRIu64 " without response path", request.requestId);
+        return;
+    }
+
+    {
+        // the response acks the earlier handled requests of the client
+        std::lock_guard<std::mutex> lock(m_handlerMutex);
+        auto entry = findHandlerEntry(request.dbName, request.tableName);
+        if (entry != nullptr)
+        {
+            auto handled = entry->handledRequests.find(request.clientId);
+            if (handled != entry->handledRequests.end() && handled->second <= request.requestId)
+            {
+                entry->handledRequests.erase(handled);
+            }
+        }
+    }
+
+    queueResponses({ { request.clientId, request.requestId } }, request.dbName.str(), request.tableName.str(), values);
 }
+
+void ZmqServer::queueResponses(
+        const std::vector<std::pair<std::string, uint64_t>>& requests,
+        const std::string& dbName,
+        const std::string& tableName,
+        const std::vector<swss::KeyOpFieldsValuesTuple>& values)
+{
+    auto format = BinarySerializer::Format::V2_FIELD_DICTIONARY;
+    std::string payload(BinarySerializer::serializedSize(dbName, tableName, values, format), '\0');
+    payload.resize(BinarySerializer::serializeBuffer(&payload[0], payload.size(), dbName, tableName, values, format));
+
+    {
+        std::lock_guard<std::mutex> lock(m_responseMutex);
+        for (auto& request : requests)
+        {
+            m_responseQueue.push_back(PendingResponse{request.first, request.second, payload});
+        }
+    }
+
+    uint64_t one = 1;
+    if (write(m_responseEvent, &one, sizeof(one)) < 0)
+    {
+        SWSS_LOG_WARN("ZmqServer failed to write eventfd, errno: %d", errno);
+    }
+}
+
+ZmqCompressionStats ZmqServer::getCompressionStats()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_compressionStats;
+}
+
+void ZmqServer::sendShmResponse(ShmClient& client, const PendingResponse& response)
+{
+    // The response of a shared memory client is the frame size, the acked request id and the payload.
+    // A frame must go out whole or the client reads the rest as the next frame, the unsent tail is
+    // written once the socket is writable and the newer frames are queued behind it.
+    uint64_t frame[2] = { sizeof(uint64_t) + response.payload.size(), response.requestId };
+    size_t size = sizeof(frame) + response.payload.size();
+    size_t written = 0;
+    if (client.output.empty())
+    {
+        struct iovec iov[2] = { { frame, sizeof(frame) }, { const_cast<char*>(response.payload.data()), response.payload.size() } };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        ssize_t rc = sendmsg(client.sock, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (rc < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            // the client is gone, its socket is closed by the receive thread
+            SWSS_LOG_WARN("ZmqServer failed to send response of request %" PRIu64 " to %s, errno: %d",
+                          response.requestId, response.clientId.c_str(), errno);
+            return;
+        }
+        written = rc > 0 ? static_cast<size_t>(rc) : 0;
+        if (written == size)
+        {
+            return;
+        }
+    }
+    else if (client.output.size() - client.outputOffset + size > MQ_SHM_RESPONSE_BUFFER_SIZE)
+    {
+        // dropped like on ZMQ when the client doesn't read them
+        SWSS_LOG_WARN("ZmqServer dropped response of request %" PRIu64 " to %s, the client doesn't read",
+                      response.requestId, response.clientId.c_str());
+        return;
+    }
+
+    if (written < sizeof(frame))
+    {
+        client.output.append(reinterpret_cast<const char*>(frame) + written, sizeof(frame) - written);
+        written = sizeof(frame);
+    }
+    client.output.append(response.payload, written - sizeof(frame), std::string::npos);
+}
+
+void ZmqServer::flushShmOutput(ShmClient& client)
+{
+    while (client.outputOffset < client.output.size())
+    {
+        ssize_t rc = send(client.sock, client.output.data() + client.outputOffset, client.output.size() - client.outputOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (rc < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+            {
+                SWSS_LOG_WARN("ZmqServer failed to send responses to %s, errno: %d", client.clientId.c_str(), errno);
+                break;
+            }
+            return;
+        }
+        client.outputOffset += static_cast<size_t>(rc);
+    }
+
+    client.output.clear();
+    client.outputOffset = 0;
+}
+
+void ZmqServer::sendResponses()
+{
+    std::deque<PendingResponse> responses;
+    {
+        std::lock_guard<std::mutex> lock(m_responseMutex);
+        responses.swap(m_responseQueue);
+    }
+
+    for (auto& response : responses)
+    {
+        auto shmClient = std::find_if(m_shmClients.begin(), m_shmClients.end(), [&response](const std::unique_ptr<ShmClient>& client) {
+            return client->clientId == response.clientId;
+        });
+        if (shmClient != m_shmClients.end())
+        {
+            sendShmResponse(**shmClient, response);
+            continue;
+        }
+
+        // ROUTER drops the message when the client is gone or its queue is full
+        if (!m_socket
+            || zmq_send(m_socket, response.clientId.data(), response.clientId.size(), ZMQ_DONTWAIT | ZMQ_SNDMORE) < 0
+            || zmq_send(m_socket, &response.requestId, sizeof(response.requestId), ZMQ_DONTWAIT | ZMQ_SNDMORE) < 0
+            || zmq_send(m_socket, response.payload.data(), response.payload.size(), ZMQ_DONTWAIT) < 0)
+        {
+            SWSS_LOG_WARN("ZmqServer failed to send response of request %" PRIu64 ", endpoint: %s, zmqerrno: %d",
+                          response.requestId, m_endpoint.c_str(), zmq_errno());
+        }
+    }
+}
+
 }
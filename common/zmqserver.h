@@ -4,7 +4,9 @@
 #include <deque>
 #include <condition_variable>
 #include <vector>
+#include <unordered_map>
 #include "table.h"
+#include "zmqcompression.h"
 
 #define MQ_RESPONSE_MAX_COUNT (16*1024*1024)
 #define MQ_SIZE 100
@@ -12,16 +14,38 @@
 #define MQ_POLL_TIMEOUT (1000)
 #define MQ_WATERMARK 10000
 
+/*
+ * The request id frame may carry one more byte: the ZmqCompression codec of
+ * the payload, or MQ_CODEC_PROBE for a probe of the codecs the peers share,
+ * its payload is the codec mask of the sender. The answer is the shared
+ * codec mask, followed by MQ_PROBE_FORMAT_V2 if the server decodes the V2
+ * wire formats.
+ */
+#define MQ_CODEC_PROBE 0xff
+#define MQ_PROBE_FORMAT_V2 0x01
+
 /***** ZMQ PORT *****/
 static const int ORCH_ZMQ_PORT = 8100;
 
 namespace swss {
 
+struct KcoViewMessage;
+struct BinaryStringView;
+class ShmRing;
+
 class ZmqMessageHandler
 {
 public:
     virtual ~ZmqMessageHandler() {};
     virtual void handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos) = 0;
+
+    /*
+     * Handle a message viewing the receive buffer, the default copies it into tuples.
+     * Return true when the request of the message is handled on return, a
+     * handler that queues it returns false and calls ZmqServer::setRequestHandled()
+     * once it is consumed.
+     */
+    virtual bool handleReceivedMessage(std::shared_ptr<const KcoViewMessage> message);
 };
 
 class ZmqServer
@@ -32,7 +56,16 @@ public:
 
     ZmqServer(const std::string& endpoint);
     ZmqServer(const std::string& endpoint, const std::string& vrf);
-    ZmqServer(const std::string& endpoint, const std::string& vrf, bool lazyBind);
+    /*
+     * With dispatchThreads > 0, the messages are handled by a pool of worker
+     * threads instead of the receive thread. Every table is handled by one
+     * worker, so the messages of a table are still handled in order, while
+     * a slow handler doesn't delay the tables of the other workers.
+     * With enableResponse, the server binds a ROUTER socket to respond to
+     * DEALER clients, see ZmqClient, instead of the PULL socket of the
+     * PUSH clients. Both sides must agree on it.
+     */
+    ZmqServer(const std::string& endpoint, const std::string& vrf, bool lazyBind, size_t dispatchThreads = 0, bool enableResponse = false);
     ~ZmqServer();
 
     void registerMessageHandler(
@@ -40,21 +73,98 @@ public:
                                 const std::string tableName,
                                 ZmqMessageHandler* handler);
 
+    /*
+     * Respond to every client with the last handled request of the table,
+     * the response acks that request and every earlier one of the client.
+     * The response is queued and sent by the receive thread.
+     */
     void sendMsg(const std::string& dbName, const std::string& tableName,
         const std::vector<swss::KeyOpFieldsValuesTuple>& values);
 
+    /* Respond to the request of a received message */
+    void sendMsg(const KcoViewMessage& request,
+        const std::vector<swss::KeyOpFieldsValuesTuple>& values);
+
+    /* Mark a request as handled, for handlers that queue the received messages */
+    void setRequestHandled(const std::string& dbName, const std::string& tableName,
+        const std::string& clientId, uint64_t requestId);
+
     void bind();
 
+    /* Counters of the decompressed requests */
+    ZmqCompressionStats getCompressionStats();
+
 private:
-    void handleReceivedData(const char* buffer, const size_t size);
+    class DispatchWorker;
+
+    struct HandlerEntry
+    {
+        std::string dbName;
+        std::string tableName;
+        ZmqMessageHandler* handler;
+        size_t worker;
+        // Client id to its last handled request of the table, not responded yet
+        std::unordered_map<std::string, uint64_t> handledRequests;
+    };
+
+    /* A same host client writing to a shared memory ring */
+    struct ShmClient
+    {
+        std::string clientId;
+        int sock;
+        // null until the client sent it on the socket
+        std::unique_ptr<ShmRing> ring;
+        // response frames not fully written to the socket yet, the
+        // bytes before outputOffset are written
+        std::string output;
+        size_t outputOffset = 0;
+    };
+
+    struct PendingResponse
+    {
+        std::string clientId;
+        uint64_t requestId;
+        std::string payload;
+    };
+
+    void handleReceivedData(ZmqMessageHandler* handler, const char* buffer, const size_t size, std::shared_ptr<const void> owner,
+                            const std::string& clientId, uint64_t requestId);
 
     void startMqPollThread();
 
     void mqPollThread();
-    
-    ZmqMessageHandler* findMessageHandler(const std::string dbName, const std::string tableName);
 
-    std::vector<char> m_buffer;
+    void recvZmqMessage();
+
+    void dispatchMessage(const BinaryStringView& clientId, uint64_t requestId, const char* data, size_t size, std::shared_ptr<const void> owner);
+
+    void acceptShmClient();
+
+    bool recvShmRing(ShmClient& client);
+
+    void recvShmMessages(ShmClient& client);
+
+    void sendShmResponse(ShmClient& client, const PendingResponse& response);
+
+    void flushShmOutput(ShmClient& client);
+
+    static uint64_t getTableId(const char* dbName, size_t dbNameLen, const char* tableName, size_t tableNameLen);
+
+    // m_handlerMutex must be held
+    HandlerEntry* findHandlerEntry(const BinaryStringView& dbName, const BinaryStringView& tableName);
+
+    ZmqMessageHandler* findMessageHandler(const BinaryStringView& dbName,
+                                          const BinaryStringView& tableName,
+                                          size_t& worker);
+
+    void setRequestHandled(const BinaryStringView& dbName, const BinaryStringView& tableName,
+                           const std::string& clientId, uint64_t requestId);
+
+    void queueResponses(const std::vector<std::pair<std::string, uint64_t>>& requests,
+                        const std::string& dbName, const std::string& tableName,
+                        const std::vector<swss::KeyOpFieldsValuesTuple>& values);
+
+    void sendResponses();
 
     volatile bool m_runThread;
 
@@ -68,7 +178,37 @@ private:
 
     void* m_socket;
 
-    std::map<std::string, std::map<std::string, ZmqMessageHandler*>> m_HandlerMap;
+    bool m_enableResponse;
+
+    std::mutex m_handlerMutex;
+
+    // Handlers keyed by the table id of their DB name and table name,
+    // the names are compared on lookup in case of hash collision.
+    std::unordered_map<uint64_t, std::vector<HandlerEntry>> m_handlerMap;
+
+    std::vector<std::unique_ptr<DispatchWorker>> m_workers;
+
+    size_t m_nextWorker;
+
+    std::mutex m_responseMutex;
+
+    std::deque<PendingResponse> m_responseQueue;
+
+    // eventfd to wake up the receive thread for the queued responses
+    int m_responseEvent;
+
+    std::string m_shmPath;
+
+    int m_shmListener;
+
+    // owned by the receive thread
+    std::vector<std::unique_ptr<ShmClient>> m_shmClients;
+
+    uint64_t m_nextShmClient;
+
+    std::mutex m_statsMutex;
+
+    ZmqCompressionStats m_compressionStats;
 };
 
 }
@@ -0,0 +1,443 @@
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <atomic>
+#include <chrono>
+#include <system_error>
+#include "logger.h"
+#include "zmqshm.h"
+
+using namespace std;
+
+namespace swss {
+
+/*
+ * The head and tail count the bytes written and consumed since the ring was
+ * created, the offset of a position is the count modulo the capacity.
+ * Every message is a record of its size and data, aligned to 8 bytes.
+ * A record that doesn't fit before the end of the ring is preceded by a
+ * padding record up to the end.
+ */
+struct ShmRing::Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> producerWaiting;
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> consumerWaiting;
+};
+
+static const uint32_t SHM_RING_MAGIC = 0x5357534d;
+static const uint32_t SHM_RING_VERSION = 1;
+static const uint64_t SHM_RECORD_PADDING = UINT64_MAX;
+static const size_t SHM_RECORD_HEADER = sizeof(uint64_t);
+static const size_t SHM_HEADER_SIZE = 4096;
+
+// The size of the ring is fixed, so the peer can't shrink it under the mapping of the other side
+static const int SHM_RING_SEALS = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+static size_t recordSize(size_t size)
+{
+    return (SHM_RECORD_HEADER + size + 7) & ~static_cast<size_t>(7);
+}
+
+ShmRing::ShmRing(size_t capacity)
+    : m_memFd(-1)
+    , m_dataEvent(-1)
+    , m_spaceEvent(-1)
+    , m_capacity((capacity + 7) & ~static_cast<size_t>(7))
+    , m_header(nullptr)
+    , m_data(nullptr)
+    , m_reservedPad(0)
+    , m_frontRecord(0)
+{
+    static_assert(sizeof(Header) <= SHM_HEADER_SIZE, "shared memory ring header doesn't fit");
+
+    m_memFd = memfd_create("swss-zmq-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    m_dataEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_spaceEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_memFd < 0 || m_dataEvent < 0 || m_spaceEvent < 0
+        || ftruncate(m_memFd, static_cast<off_t>(SHM_HEADER_SIZE + m_capacity)) != 0
+        || fcntl(m_memFd, F_ADD_SEALS, SHM_RING_SEALS) != 0)
+    {
+        int err = errno;
+        release();
+        throw system_error(err, generic_category(), "failed to create shared memory ring");
+    }
+
+    try
+    {
+        map(SHM_HEADER_SIZE + m_capacity);
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+
+    new (m_header) Header();
+    m_header->magic = SHM_RING_MAGIC;
+    m_header->version = SHM_RING_VERSION;
+    m_header->capacity = m_capacity;
+    m_header->head = 0;
+    m_header->producerWaiting = 0;
+    m_header->tail = 0;
+    m_header->consumerWaiting = 0;
+}
+
+ShmRing::ShmRing(int memFd, int dataEvent, int spaceEvent)
+    : m_memFd(memFd)
+    , m_dataEvent(dataEvent)
+    , m_spaceEvent(spaceEvent)
+    , m_capacity(0)
+    , m_header(nullptr)
+    , m_data(nullptr)
+    , m_reservedPad(0)
+    , m_frontRecord(0)
+{
+    try
+    {
+        // the producer is another process, check the ring before trusting it
+        int seals = fcntl(m_memFd, F_GET_SEALS);
+        if (seals < 0 || (seals & SHM_RING_SEALS) != SHM_RING_SEALS)
+        {
+            SWSS_LOG_THROW("shared memory ring is not sealed, seals: 0x%x", seals);
+        }
+
+        struct stat st;
+        if (fstat(m_memFd, &st) != 0 || static_cast<size_t>(st.st_size) <= SHM_HEADER_SIZE)
+        {
+            SWSS_LOG_THROW("shared memory ring is too small");
+        }
+
+        m_capacity = static_cast<size_t>(st.st_size) - SHM_HEADER_SIZE;
+        map(static_cast<size_t>(st.st_size));
+        if (m_header->magic != SHM_RING_MAGIC || m_header->version != SHM_RING_VERSION
+            || m_header->capacity != m_capacity || m_capacity % 8 != 0)
+        {
+            SWSS_LOG_THROW("shared memory ring is invalid, version: %u, capacity: %zu",
+                           m_header->version, static_cast<size_t>(m_header->capacity));
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+}
+
+ShmRing::~ShmRing()
+{
+    release();
+}
+
+void ShmRing::release()
+{
+    if (m_header)
+    {
+        munmap(m_header, SHM_HEADER_SIZE + m_capacity);
+        m_header = nullptr;
+    }
+
+    for (int* fd : { &m_memFd, &m_dataEvent, &m_spaceEvent })
+    {
+        if (*fd >= 0)
+        {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void ShmRing::map(size_t mapSize)
+{
+    void* addr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_memFd, 0);
+    if (addr == MAP_FAILED)
+    {
+        throw system_error(errno, generic_category(), "failed to map shared memory ring");
+    }
+
+    m_header = static_cast<Header*>(addr);
+    m_data = static_cast<char*>(addr) + SHM_HEADER_SIZE;
+}
+
+void ShmRing::signal(int fd)
+{
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        SWSS_LOG_WARN("failed to signal shared memory ring, errno: %d", errno);
+    }
+}
+
+size_t ShmRing::getMaxMessageSize() const
+{
+    return m_capacity / 2 - SHM_RECORD_HEADER - 8;
+}
+
+char* ShmRing::reserve(size_t size, int timeoutMs)
+{
+    if (size > getMaxMessageSize())
+    {
+        SWSS_LOG_THROW("message of %zu bytes doesn't fit the shared memory ring of %zu bytes", size, m_capacity);
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    size_t record = recordSize(size);
+    uint64_t head = m_header->head.load(memory_order_relaxed);
+    size_t offset = static_cast<size_t>(head % m_capacity);
+    m_reservedPad = offset + record > m_capacity ? m_capacity - offset : 0;
+    while (true)
+    {
+        if (head + m_reservedPad + record - m_header->tail.load() <= m_capacity)
+        {
+            return m_data + (m_reservedPad ? 0 : offset) + SHM_RECORD_HEADER;
+        }
+
+        // Sleep until the consumer frees space, the flag is checked after every pop
+        m_header->producerWaiting = 1;
+        if (head + m_reservedPad + record - m_header->tail.load() > m_capacity)
+        {
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+            if (remaining <= 0)
+            {
+                m_header->producerWaiting = 0;
+                return nullptr;
+            }
+
+            struct pollfd pfd = { m_spaceEvent, POLLIN, 0 };
+            poll(&pfd, 1, static_cast<int>(remaining));
+            uint64_t count;
+            if (read(m_spaceEvent, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            {
+                SWSS_LOG_WARN("failed to read shared memory ring event, errno: %d", errno);
+            }
+        }
+        m_header->producerWaiting = 0;
+    }
+}
+
+void ShmRing::commit(size_t size)
+{
+    uint64_t head = m_header->head.load(memory_order_relaxed);
+    if (m_reservedPad)
+    {
+        uint64_t padding = SHM_RECORD_PADDING;
+        memcpy(m_data + head % m_capacity, &padding, sizeof(padding));
+        head += m_reservedPad;
+        m_reservedPad = 0;
+    }
+
+    uint64_t recordLength = size;
+    memcpy(m_data + head % m_capacity, &recordLength, sizeof(recordLength));
+    m_header->head = head + recordSize(size);
+
+    if (m_header->consumerWaiting.load())
+    {
+        signal(m_dataEvent);
+    }
+}
+
+bool ShmRing::front(const char*& data, size_t& size)
+{
+    uint64_t tail = m_header->tail.load(memory_order_relaxed);
+    uint64_t head = m_header->head.load(memory_order_acquire);
+    if (head - tail > m_capacity)
+    {
+        SWSS_LOG_THROW("shared memory ring is corrupted, head: %zu, tail: %zu", static_cast<size_t>(head), static_cast<size_t>(tail));
+    }
+
+    while (tail != head)
+    {
+        size_t offset = static_cast<size_t>(tail % m_capacity);
+        uint64_t length;
+        memcpy(&length, m_data + offset, sizeof(length));
+        if (length == SHM_RECORD_PADDING)
+        {
+            tail += m_capacity - offset;
+            m_header->tail = tail;
+            continue;
+        }
+
+        if (length > m_capacity - offset - SHM_RECORD_HEADER || recordSize(static_cast<size_t>(length)) > head - tail)
+        {
+            SWSS_LOG_THROW("shared memory ring is corrupted, record length: %zu", static_cast<size_t>(length));
+        }
+
+        data = m_data + offset + SHM_RECORD_HEADER;
+        size = static_cast<size_t>(length);
+        m_frontRecord = recordSize(size);
+        return true;
+    }
+
+    return false;
+}
+
+void ShmRing::pop()
+{
+    m_header->tail = m_header->tail.load(memory_order_relaxed) + m_frontRecord;
+    m_frontRecord = 0;
+
+    if (m_header->producerWaiting.load())
+    {
+        signal(m_spaceEvent);
+    }
+}
+
+bool ShmRing::prepareWait()
+{
+    m_header->consumerWaiting = 1;
+    if (m_header->head.load() != m_header->tail.load(memory_order_relaxed))
+    {
+        m_header->consumerWaiting = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void ShmRing::finishWait()
+{
+    m_header->consumerWaiting = 0;
+    uint64_t count;
+    if (read(m_dataEvent, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        SWSS_LOG_WARN("failed to read shared memory ring event, errno: %d", errno);
+    }
+}
+
+static void fillAddress(const std::string& path, struct sockaddr_un& addr)
+{
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        SWSS_LOG_THROW("shared memory endpoint path is too long: %s", path.c_str());
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+}
+
+int ShmConnection::connect(const std::string& path)
+{
+    struct sockaddr_un addr;
+    fillAddress(path, addr);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        throw system_error(errno, generic_category(), "failed to create unix socket");
+    }
+
+    if (::connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        SWSS_LOG_DEBUG("shared memory server %s is not there yet, errno: %d", path.c_str(), errno);
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+void ShmConnection::sendRing(int sock, const ShmRing& ring)
+{
+    uint32_t hello = SHM_RING_MAGIC;
+    struct iovec iov = { &hello, sizeof(hello) };
+    int fds[3] = { ring.getMemFd(), ring.getDataEvent(), ring.getSpaceEvent() };
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(hello))
+    {
+        throw system_error(errno, generic_category(), "failed to send shared memory ring");
+    }
+}
+
+int ShmConnection::listen(const std::string& path)
+{
+    struct sockaddr_un addr;
+    fillAddress(path, addr);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        throw system_error(errno, generic_category(), "failed to create unix socket");
+    }
+
+    // a stale socket of a previous server blocks the bind
+    unlink(path.c_str());
+    if (::bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0
+        || ::listen(sock, SOMAXCONN) != 0)
+    {
+        int err = errno;
+        close(sock);
+        throw system_error(err, generic_category(), "failed to listen on " + path);
+    }
+
+    return sock;
+}
+
+std::unique_ptr<ShmRing> ShmConnection::recvRing(int sock)
+{
+    uint32_t hello = 0;
+    struct iovec iov = { &hello, sizeof(hello) };
+    int fds[3] = { -1, -1, -1 };
+    char control[CMSG_SPACE(sizeof(fds))];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    memset(control, 0, sizeof(control));
+    ssize_t rc = recvmsg(sock, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (rc == sizeof(hello))
+    {
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+            && cmsg->cmsg_len == CMSG_LEN(sizeof(fds)))
+        {
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+        }
+    }
+
+    if (rc != sizeof(hello) || hello != SHM_RING_MAGIC || fds[0] < 0 || fds[1] < 0 || fds[2] < 0)
+    {
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        SWSS_LOG_THROW("failed to receive shared memory ring from client");
+    }
+
+    return std::unique_ptr<ShmRing>(new ShmRing(fds[0], fds[1], fds[2]));
+}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+/* ZmqClient/ZmqServer endpoint of the shared memory transport, followed by a unix socket path */
+#define MQ_SHM_ENDPOINT_PREFIX "shm://"
+
+/* Ring size of a shared memory client */
+#define MQ_SHM_RING_SIZE (64 * 1024 * 1024)
+
+/* How long a send waits for the consumer to free ring space */
+#define MQ_SHM_SEND_TIMEOUT_MS 10000
+
+/* Responses a server buffers for a shared memory client not reading its socket, newer ones are dropped */
+#define MQ_SHM_RESPONSE_BUFFER_SIZE (64 * 1024 * 1024)
+
+namespace swss {
+
+/*
+ * Single producer single consumer ring of messages in a memfd, shared by a
+ * ZmqClient and a ZmqServer on the same host. The producer writes messages
+ * in place and the consumer reads them in place, eventfds wake up the other
+ * side only when it sleeps.
+ */
+class ShmRing
+{
+public:
+    /* Create a ring in a new memfd, for the producer */
+    ShmRing(size_t capacity);
+
+    /* Map the ring of a producer, the ring owns the fds, throw if the ring is invalid or not sealed */
+    ShmRing(int memFd, int dataEvent, int spaceEvent);
+
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    int getMemFd() const { return m_memFd; }
+
+    /* Signaled when the consumer sleeps and a message is written */
+    int getDataEvent() const { return m_dataEvent; }
+
+    /* Signaled when the producer sleeps and a message is consumed */
+    int getSpaceEvent() const { return m_spaceEvent; }
+
+    size_t getCapacity() const { return m_capacity; }
+
+    /* Messages up to half of the ring fit in any ring state */
+    size_t getMaxMessageSize() const;
+
+    /* Producer: buffer for the next message of up to size bytes, nullptr if the ring stays full for timeoutMs */
+    char* reserve(size_t size, int timeoutMs);
+
+    /* Producer: publish the reserved message with its actual size */
+    void commit(size_t size);
+
+    /* Consumer: the oldest message, false if the ring is empty, throw if the ring is corrupted */
+    bool front(const char*& data, size_t& size);
+
+    /* Consumer: release the message of front() */
+    void pop();
+
+    /* Consumer: call before sleeping on the data event, false if a message came in meanwhile */
+    bool prepareWait();
+
+    /* Consumer: call after sleeping on the data event */
+    void finishWait();
+
+private:
+    struct Header;
+
+    void map(size_t mapSize);
+
+    void release();
+
+    static void signal(int fd);
+
+    int m_memFd;
+    int m_dataEvent;
+    int m_spaceEvent;
+    size_t m_capacity;
+    Header* m_header;
+    char* m_data;
+
+    // producer: padding to skip before the reserved message
+    size_t m_reservedPad;
+
+    // consumer: record size of the front message
+    size_t m_frontRecord;
+};
+
+/* Hand over of the ring from a client to the server through a unix socket */
+class ShmConnection
+{
+public:
+    /* Connect to the server listening on path, -1 if it is not there yet */
+    static int connect(const std::string& path);
+
+    /* Send the fds of the ring over the connected socket */
+    static void sendRing(int sock, const ShmRing& ring);
+
+    /* Listen on path for the clients */
+    static int listen(const std::string& path);
+
+    /* Receive the ring of a client connection once the socket is readable, throw if it is not a sealed ring */
+    static std::unique_ptr<ShmRing> recvRing(int sock);
+};
+
+}
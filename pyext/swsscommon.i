@@ -277,12 +277,16 @@ T castSelectableObj(swss::Selectable *temp)
 %include "selectable.h"
 %include "select.h"
 %include "rediscommand.h"
+// move-only reply vector, Table::get()/hget() of a key list use it
+%ignore swss::RedisPipeline::pushBatch;
 %include "redispipeline.h"
 %include "redisreply.h"
 %include "redisselect.h"
 %include "redistran.h"
 %include "configdb.h"
 %include "zmqserver.h"
+// the const reference wait() is the scripting interface
+%ignore swss::ZmqClient::wait(std::string &, std::string &, std::vector<std::shared_ptr<swss::KeyOpFieldsValuesTuple>> &);
 %include "zmqclient.h"
 %include "zmqconsumerstatetable.h"
 %include "interface.h"
@@ -292,6 +296,12 @@ T castSelectableObj(swss::Selectable *temp)
 }
 
 %ignore swss::TableEntryPoppable::pops(std::deque<KeyOpFieldsValuesTuple> &, const std::string &);
+// batched reads and the entry walk, the key at a time get()/hget() and scanKeys() are wrapped
+%ignore swss::Table::get(const std::vector<std::string> &, std::vector<std::pair<bool, std::vector<std::pair<std::string, std::string>>>> &);
+%ignore swss::Table::hget(const std::vector<std::string> &, const std::string &, std::vector<std::pair<bool, std::string>> &);
+%ignore swss::Table::forEachEntry;
+%ignore swss::DecoratorTable::get(const std::vector<std::string> &, std::vector<std::pair<bool, std::vector<std::pair<std::string, std::string>>>> &);
+%ignore swss::DecoratorTable::hget(const std::vector<std::string> &, const std::string &, std::vector<std::pair<bool, std::string>> &);
 %apply std::vector<std::string>& OUTPUT {std::vector<std::string> &keys};
 %apply std::vector<std::string>& OUTPUT {std::vector<std::string> &ops};
 %apply std::vector<std::vector<std::pair<std::string, std::string>>>& OUTPUT {std::vector<std::vector<std::pair<std::string, std::string>>> &fvss};
@@ -327,6 +337,7 @@ T castSelectableObj(swss::Selectable *temp)
 #endif
 
 %include "producerstatetable.h"
+%ignore swss::ZmqProducerStateTable::wait(std::string &, std::string &, std::vector<std::shared_ptr<swss::KeyOpFieldsValuesTuple>> &);
 %include "zmqproducerstatetable.h"
 
 %apply std::string& OUTPUT {std::string &key};
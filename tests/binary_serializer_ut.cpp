@@ -1,4 +1,5 @@
 #include <iostream>
+#include <chrono>
 #include "gtest/gtest.h"
 
 #include "common/table.h"
@@ -125,3 +126,159 @@ TEST(BinarySerializer, protocol_buffer)
     EXPECT_EQ(db_table, test_table);
     EXPECT_EQ(deserialized_kcos, kcos);
 }
+
+TEST(BinarySerializer, deserialize_view)
+{
+    char buffer[200];
+    std::vector<KeyOpFieldsValuesTuple> kcos = std::vector<KeyOpFieldsValuesTuple>{
+        KeyOpFieldsValuesTuple{"key1", "SET", { {"f1", "v1"}, {"f2", string("\0v2", 3)} }},
+        KeyOpFieldsValuesTuple{"key2", "DEL", {}},
+        KeyOpFieldsValuesTuple{"key3", "SET", { {"f3", ""} }}};
+    size_t serialized_len = BinarySerializer::serializeBuffer(buffer, sizeof(buffer), "test_db", "test_table", kcos);
+
+    KcoViewMessage message;
+    BinarySerializer::deserializeBuffer(buffer, serialized_len, message);
+
+    EXPECT_TRUE(message.dbName == "test_db");
+    EXPECT_TRUE(message.tableName == "test_table");
+    ASSERT_EQ(message.kcos.size(), kcos.size());
+
+    // Views point into the serialized buffer
+    EXPECT_GE(message.kcos[0].key.data, buffer);
+    EXPECT_LT(message.kcos[0].key.data, buffer + serialized_len);
+    EXPECT_TRUE(message.kcos[1].isDel());
+    for (size_t i = 0; i < kcos.size(); i++)
+    {
+        EXPECT_EQ(message.kcos[i].toKco(), kcos[i]);
+    }
+
+    EXPECT_THROW(BinarySerializer::deserializeBuffer(buffer, serialized_len - 1, message), runtime_error);
+    EXPECT_THROW(BinarySerializer::deserializeBuffer(buffer, 4, message), runtime_error);
+}
+
+TEST(BinarySerializer, format_v2)
+{
+    std::vector<KeyOpFieldsValuesTuple> kcos = std::vector<KeyOpFieldsValuesTuple>{
+        KeyOpFieldsValuesTuple{"key1", "SET", { {"f1", "v1"}, {"f2", string("\0v2", 3)} }},
+        KeyOpFieldsValuesTuple{"key2", "DEL", {}},
+        KeyOpFieldsValuesTuple{"key3", "SET", {}},
+        KeyOpFieldsValuesTuple{"key4", "SET", { {"f2", ""}, {"f1", string(300, 'x')} }}};
+
+    // Enough field names for the dictionary to index them
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<FieldValueTuple> fvs;
+        for (int j = 0; j < 40; j++)
+        {
+            fvs.emplace_back("field" + to_string(j), to_string(i * j));
+        }
+        kcos.emplace_back("key" + to_string(5 + i), "SET", fvs);
+    }
+
+    for (auto format : { BinarySerializer::Format::V2, BinarySerializer::Format::V2_FIELD_DICTIONARY })
+    {
+        std::vector<char> buffer(BinarySerializer::serializedSize("test_db", "test_table", kcos, format));
+        size_t serialized_len = BinarySerializer::serializeBuffer(buffer.data(), buffer.size(), "test_db", "test_table", kcos, format);
+        EXPECT_LE(serialized_len, buffer.size());
+
+        KcoViewMessage message;
+        BinarySerializer::deserializeBuffer(buffer.data(), serialized_len, message);
+        EXPECT_TRUE(message.dbName == "test_db");
+        EXPECT_TRUE(message.tableName == "test_table");
+        ASSERT_EQ(message.kcos.size(), kcos.size());
+        for (size_t i = 0; i < kcos.size(); i++)
+        {
+            EXPECT_EQ(message.kcos[i].toKco(), kcos[i]);
+        }
+
+        // The operation is explicit, a SET without attribute is not a DEL
+        EXPECT_TRUE(message.kcos[1].isDel());
+        EXPECT_FALSE(message.kcos[2].isDel());
+
+        BinaryStringView dbName, tableName;
+        BinarySerializer::deserializeHeader(buffer.data(), serialized_len, dbName, tableName);
+        EXPECT_TRUE(dbName == "test_db");
+        EXPECT_TRUE(tableName == "test_table");
+
+        for (size_t len = 0; len < serialized_len; len++)
+        {
+            EXPECT_THROW(BinarySerializer::deserializeBuffer(buffer.data(), len, message), runtime_error);
+        }
+    }
+
+    // The dictionary sends the repeated field names once
+    std::vector<char> buffer(BinarySerializer::serializedSize("test_db", "test_table", kcos, BinarySerializer::Format::V2));
+    EXPECT_LT(BinarySerializer::serializeBuffer(buffer.data(), buffer.size(), "test_db", "test_table", kcos, BinarySerializer::Format::V2_FIELD_DICTIONARY),
+              BinarySerializer::serializeBuffer(buffer.data(), buffer.size(), "test_db", "test_table", kcos, BinarySerializer::Format::V2));
+}
+
+// A route request of many similar KCOs
+static std::vector<KeyOpFieldsValuesTuple> createRouteKcos()
+{
+    std::vector<KeyOpFieldsValuesTuple> kcos;
+    for (int i = 0; i < 128; i++)
+    {
+        kcos.emplace_back("oid:0x2d00000000" + to_string(i), "SET", std::vector<FieldValueTuple>{
+            {"SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION", "SAI_PACKET_ACTION_FORWARD"},
+            {"SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID", "oid:0x400000000" + to_string(i)},
+            {"SAI_ROUTE_ENTRY_ATTR_META_DATA", to_string(i)} });
+    }
+    return kcos;
+}
+
+// A request of many similar KCOs round trips in every format, each format smaller than the previous one
+TEST(BinarySerializer, format_sizes)
+{
+    auto kcos = createRouteKcos();
+
+    size_t previous_len = SIZE_MAX;
+    for (auto format : { BinarySerializer::Format::V1, BinarySerializer::Format::V2, BinarySerializer::Format::V2_FIELD_DICTIONARY })
+    {
+        std::vector<char> buffer(BinarySerializer::serializedSize("APPL_DB", "ROUTE_TABLE", kcos, format));
+        size_t serialized_len = BinarySerializer::serializeBuffer(buffer.data(), buffer.size(), "APPL_DB", "ROUTE_TABLE", kcos, format);
+        EXPECT_LT(serialized_len, previous_len);
+        previous_len = serialized_len;
+
+        KcoViewMessage message;
+        BinarySerializer::deserializeBuffer(buffer.data(), serialized_len, message);
+        EXPECT_EQ(message.dbName.str(), "APPL_DB");
+        EXPECT_EQ(message.tableName.str(), "ROUTE_TABLE");
+        ASSERT_EQ(message.kcos.size(), kcos.size());
+        for (size_t i = 0; i < kcos.size(); i++)
+        {
+            EXPECT_EQ(message.kcos[i].toKco(), kcos[i]);
+        }
+    }
+}
+
+// Benchmark of the bytes and the time to serialize and decode a request,
+// run with --gtest_also_run_disabled_tests
+TEST(BinarySerializer, DISABLED_format_benchmark)
+{
+    auto kcos = createRouteKcos();
+
+    const int rounds = 2000;
+    for (auto format : { BinarySerializer::Format::V1, BinarySerializer::Format::V2, BinarySerializer::Format::V2_FIELD_DICTIONARY })
+    {
+        std::vector<char> buffer(BinarySerializer::serializedSize("APPL_DB", "ROUTE_TABLE", kcos, format));
+        size_t serialized_len = 0;
+        KcoViewMessage message;
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++)
+        {
+            serialized_len = BinarySerializer::serializeBuffer(buffer.data(), buffer.size(), "APPL_DB", "ROUTE_TABLE", kcos, format);
+            BinarySerializer::deserializeBuffer(buffer.data(), serialized_len, message);
+        }
+        double ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+
+        ASSERT_EQ(message.kcos.size(), kcos.size());
+        EXPECT_EQ(message.kcos.back().toKco(), kcos.back());
+        const char *name = format == BinarySerializer::Format::V1 ? "V1"
+                         : format == BinarySerializer::Format::V2 ? "V2"
+                         : "V2 with field dictionary";
+        cout << name << ": "
+             << (double)serialized_len / (double)kcos.size() << " bytes/KCO, "
+             << ns / (double)(rounds * kcos.size()) << " ns/KCO" << endl;
+    }
+}
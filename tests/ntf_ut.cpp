@@ -215,3 +215,55 @@ TEST(Notifications, pipelineProducer)
     EXPECT_EQ(rc, 0);
 }
 
+
+TEST(Notifications, queued)
+{
+    SWSS_LOG_ENTER();
+
+    swss::DBConnector dbNtf("ASIC_DB", 0, true);
+    dbNtf.del("QUEUED_NOTIFICATIONS_QUEUE");
+    dbNtf.del("QUEUED_NOTIFICATIONS_QUEUE_DROPPED");
+
+    // Notifications wait in the queue until the consumer comes up
+    swss::NotificationProducer notifications(&dbNtf, "QUEUED_NOTIFICATIONS", 150);
+    std::vector<swss::FieldValueTuple> entry{ { "bin", std::string("a\0b", 3) }, { "port", "Ethernet0" } };
+    for (int i = 0; i < 200; i++)
+    {
+        auto queued = notifications.send("ntf", std::to_string(i + 1), entry);
+        EXPECT_EQ(queued, i < 150 ? i + 1 : 0);
+    }
+    EXPECT_EQ(notifications.getDroppedCount(), 50UL);
+
+    swss::NotificationConsumer nc(&dbNtf, "QUEUED_NOTIFICATIONS", 100, 64, true);
+    EXPECT_EQ(nc.getDroppedCount(), 50UL);
+
+    // The notifications are not shared with a second consumer
+    EXPECT_THROW(swss::NotificationConsumer(&dbNtf, "QUEUED_NOTIFICATIONS", 100, 64, true), std::exception);
+
+    swss::Select s;
+    s.addSelectable(&nc);
+    swss::Selectable *sel;
+    std::deque<swss::KeyOpFieldsValuesTuple> vkco;
+    size_t collected = 0;
+    while (s.select(&sel, 1000) == swss::Select::OBJECT)
+    {
+        nc.pops(vkco);
+        EXPECT_LE(vkco.size(), 64UL);
+        for (auto &kco : vkco)
+        {
+            EXPECT_EQ(kfvOp(kco), "ntf");
+            EXPECT_EQ(kfvKey(kco), std::to_string(++collected));
+            EXPECT_EQ(kfvFieldsValues(kco), entry);
+        }
+    }
+    EXPECT_EQ(collected, 150UL);
+
+    // A new notification wakes up the drained consumer
+    notifications.send("ntf", "last", entry);
+    ASSERT_EQ(s.select(&sel, 1000), swss::Select::OBJECT);
+    std::string op, data;
+    std::vector<swss::FieldValueTuple> values;
+    nc.pop(op, data, values);
+    EXPECT_EQ(data, "last");
+    EXPECT_EQ(nc.peek(), 0);
+}
@@ -10,3 +10,33 @@ TEST(RedisCommand, invalid_redis_command)
     EXPECT_EQ(cmd.len, 0);
     EXPECT_EQ(cmd.temp, nullptr);
 }
+
+TEST(RedisCommand, incremental_argv)
+{
+    swss::RedisCommand expected;
+    expected.format(std::vector<std::string>{"HSET", "TABLE:key", "field", "", "count", "42"});
+
+    swss::RedisCommand cmd;
+    cmd.beginArgv(6);
+    cmd.appendArgv("HSET", 4);
+    cmd.appendArgv(std::string("TABLE:"), std::string("key"));
+    cmd.appendArgv(std::string("field"));
+    cmd.appendArgv(std::string());
+    cmd.appendArgv("count", 5);
+    cmd.appendArgvInteger(42);
+    EXPECT_THROW(cmd.appendArgv("extra", 5), std::logic_error);
+    EXPECT_EQ(cmd.length(), expected.length());
+    EXPECT_EQ(cmd.toPrintableString(), expected.toPrintableString());
+
+    // Reuse the buffer for a shorter command
+    cmd.beginArgv(2);
+    cmd.appendArgv("DEL", 3);
+    EXPECT_THROW(cmd.appendTo(nullptr), std::logic_error);
+    cmd.appendArgv("key", 3);
+    expected.formatDEL("key");
+    EXPECT_EQ(cmd.toPrintableString(), expected.toPrintableString());
+
+    // Formatting through hiredis takes over again
+    cmd.format("PING");
+    EXPECT_EQ(cmd.toPrintableString(), "*1\\r\\n$4\\r\\nPING\\r\\n");
+}
@@ -785,4 +785,102 @@ TEST(ConsumerStateTable, flushPub)
         int ret = cs.select(&selectcs, 1000);
         EXPECT_EQ(ret, Select::TIMEOUT);
     }
-}
\ No newline at end of file
+}
+
+TEST(ConsumerStateTable, async_coalesced)
+{
+    clearDB();
+
+    /* Prepare producer */
+    string tableName = "UT_REDIS_COALESCED";
+    DBConnector db(TEST_DB, 0, true);
+    RedisPipeline pipeline(&db);
+    ProducerStateTable p(&pipeline, tableName, true);
+    p.setCoalesced(true);
+
+    /* Flapping key: the last field values win */
+    for (int i = 0; i < 10; i++)
+    {
+        p.set("flap", { FieldValueTuple(field(i % 2), value(i)) });
+    }
+
+    /* Set then del collapses to del */
+    p.set("gone", { FieldValueTuple(field(0), value(0)) });
+    p.del("gone");
+
+    /* Del then set recreates the key with the new fields only */
+    p.set("reset", { FieldValueTuple(field(0), value(0)) });
+    p.del("reset");
+    p.set("reset", { FieldValueTuple(field(1), value(1)) });
+    EXPECT_EQ(p.getCoalescedCount(), 12UL);
+    p.flush();
+
+    /* Prepare consumer */
+    ConsumerStateTable c(&db, tableName);
+    Select cs;
+    Selectable *selectcs;
+    cs.addSelectable(&c);
+
+    map<string, KeyOpFieldsValuesTuple> popped;
+    while (cs.select(&selectcs, 1000) == Select::OBJECT)
+    {
+        std::deque<KeyOpFieldsValuesTuple> kcos;
+        c.pops(kcos);
+        for (auto &kco : kcos)
+        {
+            popped[kfvKey(kco)] = kco;
+        }
+    }
+
+    ASSERT_EQ(popped.size(), 3UL);
+    EXPECT_EQ(kfvOp(popped["flap"]), "SET");
+    map<string, string> flap;
+    for (auto &fv : kfvFieldsValues(popped["flap"]))
+    {
+        flap[fvField(fv)] = fvValue(fv);
+    }
+    EXPECT_EQ(flap, (map<string, string>{ { field(0), value(8) }, { field(1), value(9) } }));
+
+    EXPECT_EQ(kfvOp(popped["gone"]), "DEL");
+
+    EXPECT_EQ(kfvOp(popped["reset"]), "SET");
+    EXPECT_EQ(kfvFieldsValues(popped["reset"]), (vector<FieldValueTuple>{ FieldValueTuple(field(1), value(1)) }));
+}
+
+TEST(ConsumerStateTable, async_coalesced_capped)
+{
+    clearDB();
+
+    string tableName = "UT_REDIS_COALESCED_CAPPED";
+    DBConnector db(TEST_DB, 0, true);
+    RedisPipeline pipeline(&db, 4);
+    ProducerStateTable p(&pipeline, tableName, true);
+    p.setCoalesced(true);
+
+    ConsumerStateTable c(&db, tableName);
+    auto popAll = [&c]() {
+        Select cs;
+        Selectable *selectcs;
+        cs.addSelectable(&c);
+        size_t count = 0;
+        while (cs.select(&selectcs, 1000) == Select::OBJECT)
+        {
+            std::deque<KeyOpFieldsValuesTuple> kcos;
+            c.pops(kcos);
+            count += kcos.size();
+        }
+        return count;
+    };
+
+    /* A full buffer goes to the pipeline, flushing the pipeline writes it */
+    for (int i = 0; i < 10; i++)
+    {
+        p.set(key(i), { FieldValueTuple(field(0), value(i)) });
+    }
+    pipeline.flush();
+    EXPECT_EQ(popAll(), 8UL);
+
+    /* The rest stays buffered until the table is flushed */
+    p.flush();
+    EXPECT_EQ(popAll(), 2UL);
+}
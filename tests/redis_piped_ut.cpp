@@ -486,6 +486,141 @@ TEST(Table, piped_test)
     cout << "Done." << endl;
 }
 
+TEST(RedisPipeline, async_flush)
+{
+    DBConnector db("TEST_DB", 0, true);
+    clearDB();
+
+    RedisPipeline pipeline(&db, 4);
+    vector<string> errors;
+    pipeline.setAsync(true, [&](const string &error) { errors.push_back(error); });
+    RedisPipelineSelectable drainer(&pipeline);
+
+    Table t(&pipeline, "ASYNC_UT_TEST", true);
+    for (int i = 0; i < 10; i++)
+    {
+        t.hset(key(i), "f", "v");
+    }
+    t.flush();
+
+    // Commands were written, but replies are left for the event loop
+    EXPECT_EQ(pipeline.size(), 0UL);
+    EXPECT_EQ(pipeline.getInflightCount(), 10UL);
+    EXPECT_TRUE(errors.empty());
+
+    Select s;
+    s.addSelectable(&drainer);
+    while (pipeline.getInflightCount() > 0)
+    {
+        Selectable *sel;
+        ASSERT_EQ(s.select(&sel, 1000), Select::OBJECT);
+        EXPECT_EQ(sel, &drainer);
+    }
+    EXPECT_EQ(errors, vector<string>(3, ""));
+
+    // A failed command is reported through the callback of its batch
+    RedisCommand bad;
+    bad.format("INCR %s", ("ASYNC_UT_TEST:" + key(0)).c_str());
+    pipeline.push(bad, REDIS_REPLY_INTEGER);
+    pipeline.flush();
+    EXPECT_EQ(pipeline.getInflightCount(), 1UL);
+    pipeline.waitAsyncReplies();
+    ASSERT_EQ(errors.size(), 4UL);
+    EXPECT_NE(errors.back(), "");
+
+    // Synchronous commands wait for the replies in flight
+    t.hset(key(10), "f", "v");
+    pipeline.flush();
+    vector<FieldValueTuple> values;
+    EXPECT_TRUE(t.get(key(10), values));
+    EXPECT_EQ(pipeline.getInflightCount(), 0UL);
+    EXPECT_EQ(errors.size(), 5UL);
+
+    // pop() skips the replies in flight
+    t.hset(key(11), "f", "v");
+    pipeline.flush();
+    EXPECT_EQ(pipeline.getInflightCount(), 1UL);
+    RedisCommand incr;
+    incr.format("INCRBY ASYNC_UT_COUNTER 42");
+    pipeline.push(incr, REDIS_REPLY_INTEGER);
+    RedisReply counter(pipeline.pop());
+    EXPECT_EQ(counter.getContext()->integer, 42);
+    EXPECT_EQ(pipeline.getInflightCount(), 0UL);
+    EXPECT_EQ(errors.size(), 6UL);
+
+    // A flush bigger than the socket buffers is finished from the event loop
+    RedisPipeline big(&db, 1000);
+    big.setAsync(true);
+    RedisPipelineSelectable bigDrainer(&big);
+    s.addSelectable(&bigDrainer);
+    Table bigTable(&big, "ASYNC_UT_TEST", true);
+    const string value(64 * 1024, 'v');
+    for (int i = 0; i < 256; i++)
+    {
+        bigTable.hset(key(i), "big", value);
+    }
+    bigTable.flush();
+    while (big.getInflightCount() > 0)
+    {
+        Selectable *sel;
+        ASSERT_EQ(s.select(&sel, 1000), Select::OBJECT);
+        EXPECT_EQ(sel, &bigDrainer);
+    }
+    EXPECT_FALSE(big.hasPendingWrite());
+    string stored;
+    EXPECT_TRUE(bigTable.hget(key(255), "big", stored));
+    EXPECT_EQ(stored, value);
+}
+
+TEST(RedisPipeline, flush_policy)
+{
+    DBConnector db("TEST_DB", 0, true);
+    clearDB();
+
+    RedisPipeline pipeline(&db);
+    EXPECT_EQ(pipeline.getFlushPolicy().maxCommands, pipeline.COMMAND_MAX);
+
+    Table t(&pipeline, "POLICY_UT_TEST", true);
+    RedisPipelineFlushPolicy policy;
+    policy.maxBytes = 1024;
+    pipeline.setFlushPolicy(policy);
+
+    // Count limit is disabled, flushes are driven by the buffered size
+    for (int i = 0; i < 200; i++)
+    {
+        t.hset(key(i), "f", "v");
+    }
+    EXPECT_LT(pipeline.size(), 200UL);
+    EXPECT_LT(pipeline.getBufferedBytes(), 1024UL);
+    t.hset(key(1), "f", string(2048, 'x'));
+    EXPECT_EQ(pipeline.size(), 0UL);
+    EXPECT_EQ(pipeline.getBufferedBytes(), 0UL);
+
+    // The timer flushes a buffered command once it is older than maxAgeMs
+    policy.maxBytes = 0;
+    policy.maxAgeMs = 20;
+    pipeline.setFlushPolicy(policy);
+    t.hset(key(2), "f", "w");
+    EXPECT_EQ(pipeline.size(), 1UL);
+
+    RedisPipelineFlushTimer timer(&pipeline, { .tv_sec = 0, .tv_nsec = 10 * 1000 * 1000 });
+    Select s;
+    s.addSelectable(&timer);
+    timer.start();
+    for (int i = 0; i < 10 && pipeline.size() > 0; i++)
+    {
+        Selectable *sel;
+        ASSERT_EQ(s.select(&sel, 1000), Select::OBJECT);
+    }
+    timer.stop();
+    EXPECT_EQ(pipeline.size(), 0UL);
+
+    DBConnector db2("TEST_DB", 0, true);
+    auto value = db2.hget("POLICY_UT_TEST:" + key(2), "f");
+    ASSERT_TRUE(value);
+    EXPECT_EQ(*value, "w");
+}
+
 TEST(ProducerConsumer, piped_Prefix)
 {
     string tableName = "tableName";
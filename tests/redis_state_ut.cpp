@@ -12,6 +12,7 @@
 #include "common/table.h"
 #include "common/producerstatetable.h"
 #include "common/consumerstatetable.h"
+#include "common/consumertable.h"
 
 using namespace std;
 using namespace swss;
@@ -1125,6 +1126,60 @@ TEST(ConsumerStateTable, batched)
     cout << endl << "Done." << endl;
 }
 
+TEST(ConsumerStateTable, apply_mixed)
+{
+    clearDB();
+
+    string tableName = "UT_REDIS_APPLY";
+    DBConnector db(TEST_DB, 0, true);
+    ProducerStateTable p(&db, tableName);
+    p.set(key(0), { FieldValueTuple(field(0), value(0)) });
+    p.set(key(1), { FieldValueTuple(field(0), value(0)) });
+
+    ConsumerStateTable c(&db, tableName, NUMBER_OF_OPS);
+    Select cs;
+    Selectable *selectcs;
+    deque<KeyOpFieldsValuesTuple> vkco;
+    cs.addSelectable(&c);
+    ASSERT_EQ(cs.select(&selectcs), Select::OBJECT);
+    c.pops(vkco);
+    EXPECT_EQ(vkco.size(), 2U);
+    while (cs.select(&selectcs, 100) == Select::OBJECT)
+    {
+        vkco.clear();
+        c.pops(vkco);
+        EXPECT_TRUE(vkco.empty());
+    }
+
+    // Creates and removes in one script, in order
+    p.apply({
+        KeyOpFieldsValuesTuple(key(0), DEL_COMMAND, {}),
+        KeyOpFieldsValuesTuple(key(2), SET_COMMAND, { FieldValueTuple(field(0), value(0)), FieldValueTuple(field(1), value(1)) }),
+        KeyOpFieldsValuesTuple(key(1), SET_COMMAND, { FieldValueTuple(field(1), value(1)) }),
+        KeyOpFieldsValuesTuple(key(2), DEL_COMMAND, {}),
+        KeyOpFieldsValuesTuple(key(2), SET_COMMAND, { FieldValueTuple(field(2), value(2)) }),
+    });
+    EXPECT_THROW(p.apply({ KeyOpFieldsValuesTuple(key(3), "GET", {}) }), std::exception);
+
+    ASSERT_EQ(cs.select(&selectcs), Select::OBJECT);
+    vkco.clear();
+    c.pops(vkco);
+    map<string, KeyOpFieldsValuesTuple> popped;
+    for (auto &kco : vkco)
+    {
+        popped[kfvKey(kco)] = kco;
+    }
+    ASSERT_EQ(popped.size(), 3U);
+    EXPECT_EQ(kfvOp(popped[key(0)]), "DEL");
+    EXPECT_EQ(kfvOp(popped[key(1)]), "SET");
+    EXPECT_EQ(kfvFieldsValues(popped[key(1)]), (vector<FieldValueTuple>{ FieldValueTuple(field(1), value(1)) }));
+    EXPECT_EQ(kfvOp(popped[key(2)]), "SET");
+    EXPECT_EQ(kfvFieldsValues(popped[key(2)]), (vector<FieldValueTuple>{ FieldValueTuple(field(2), value(2)) }));
+
+    // One notification for the whole batch
+    EXPECT_EQ(cs.select(&selectcs, 100), Select::TIMEOUT);
+}
+
 TEST(ConsumerStateTable, test)
 {
     thread *producerThreads[NUMBER_OF_THREADS];
@@ -1223,3 +1278,144 @@ TEST(ConsumerStateTable, multitable)
 
     cout << endl << "Done." << endl;
 }
+
+TEST(ConsumerStateTable, packed_pops)
+{
+    clearDB();
+
+    string tableName = "UT_REDIS_PACKED";
+    DBConnector db(TEST_DB, 0, true);
+    ProducerStateTable p(&db, tableName);
+    Table t(&db, tableName);
+
+    /* An existing entry which will be deleted */
+    t.set("deleted", { { "field", "value" } });
+    p.del("deleted");
+
+    /* Plain entries, including an empty value */
+    for (int i = 0; i < 10; i++)
+    {
+        vector<FieldValueTuple> fields;
+        for (int j = 0; j <= i; j++)
+        {
+            fields.emplace_back(field(j), value(j));
+        }
+        p.set(key(i), fields);
+    }
+
+    /* An entry larger than a single lua unpack() can take */
+    const int numOfLargeFields = 5000;
+    vector<FieldValueTuple> largeFields;
+    for (int j = 0; j < numOfLargeFields; j++)
+    {
+        largeFields.emplace_back(field(j), value(j));
+    }
+    p.set("large", largeFields);
+
+    ConsumerStateTable c(&db, tableName, 128);
+    c.setPackedPops(true);
+
+    std::deque<KeyOpFieldsValuesTuple> vkco;
+    c.pops(vkco);
+    EXPECT_EQ(vkco.size(), 12U);
+
+    map<string, KeyOpFieldsValuesTuple> popped;
+    for (auto &kco : vkco)
+    {
+        popped[kfvKey(kco)] = kco;
+    }
+
+    EXPECT_EQ(kfvOp(popped["deleted"]), DEL_COMMAND);
+    EXPECT_TRUE(kfvFieldsValues(popped["deleted"]).empty());
+    vector<FieldValueTuple> values;
+    EXPECT_FALSE(t.get("deleted", values));
+
+    for (int i = 0; i < 10; i++)
+    {
+        auto &kco = popped[key(i)];
+        EXPECT_EQ(kfvOp(kco), SET_COMMAND);
+        map<string, string> mm(kfvFieldsValues(kco).begin(), kfvFieldsValues(kco).end());
+        EXPECT_EQ(mm.size(), (size_t)i + 1);
+        for (int j = 0; j <= i; j++)
+        {
+            EXPECT_EQ(mm[field(j)], value(j));
+        }
+
+        EXPECT_TRUE(t.get(key(i), values));
+        EXPECT_EQ(values.size(), (size_t)i + 1);
+    }
+
+    EXPECT_EQ(kfvFieldsValues(popped["large"]).size(), (size_t)numOfLargeFields);
+    EXPECT_TRUE(t.get("large", values));
+    EXPECT_EQ(values.size(), (size_t)numOfLargeFields);
+
+    /* Nothing left to pop */
+    c.pops(vkco);
+    EXPECT_TRUE(vkco.empty());
+
+    /* Switching back to the default mode keeps working */
+    p.del(key(0));
+    c.setPackedPops(false);
+    c.pops(vkco);
+    ASSERT_EQ(vkco.size(), 1U);
+    EXPECT_EQ(kfvKey(vkco[0]), key(0));
+    EXPECT_EQ(kfvOp(vkco[0]), DEL_COMMAND);
+}
+
+TEST(ConsumerStateTable, adaptive_pop_batch_size)
+{
+    clearDB();
+
+    string tableName = "UT_REDIS_ADAPTIVE";
+    DBConnector db(TEST_DB, 0, true);
+    RedisPipeline pipeline(&db);
+    ProducerStateTable p(&pipeline, tableName, true);
+
+    const int numOfKeys = 1000;
+    for (int i = 0; i < numOfKeys; i++)
+    {
+        p.set(key(i), { { field(0), value(i) } });
+    }
+    p.flush();
+
+    ConsumerStateTable c(&db, tableName, 128);
+    EXPECT_EQ(c.getPopBatchSize(), 128);
+    EXPECT_EQ(c.getPopBacklog(), -1);
+    EXPECT_THROW(c.setAdaptivePopBatchSize(0, 512, 10000000), std::runtime_error);
+    ConsumerTable ct(&db, tableName, 128);
+    EXPECT_THROW(ct.setAdaptivePopBatchSize(16, 512, 10000000), std::runtime_error);
+    c.setAdaptivePopBatchSize(16, 512, 10000000);
+
+    /* The batch grows while the backlog is larger than a batch */
+    std::deque<KeyOpFieldsValuesTuple> vkco;
+    vector<size_t> popped;
+    do
+    {
+        c.pops(vkco);
+        popped.push_back(vkco.size());
+    } while (!vkco.empty());
+    EXPECT_EQ(popped, vector<size_t>({ 128, 256, 512, 104, 0 }));
+    EXPECT_EQ(c.getPopBatchSize(), 512);
+    EXPECT_EQ(c.getPopBacklog(), 0);
+
+    /* The batch shrinks down to the minimum when over the latency budget */
+    c.setAdaptivePopBatchSize(16, 512, 0);
+    for (int i = 0; i < numOfKeys; i++)
+    {
+        p.set(key(i), { { field(1), value(i) } });
+    }
+    p.flush();
+    c.pops(vkco);
+    EXPECT_EQ(vkco.size(), 512U);
+    EXPECT_EQ(c.getPopBatchSize(), 256);
+    EXPECT_EQ(c.getPopBacklog(), numOfKeys - 512);
+    for (int i = 0; i < 5; i++)
+    {
+        c.pops(vkco);
+    }
+    EXPECT_EQ(c.getPopBatchSize(), 16);
+
+    c.disableAdaptivePopBatchSize();
+    EXPECT_EQ(c.getPopBatchSize(), 128);
+    EXPECT_FALSE(c.isAdaptivePopBatchSize());
+}
@@ -906,6 +906,108 @@ TEST(Table, binary_data_get)
     EXPECT_EQ(*f2, v2);
 }
 
+TEST(Table, batched_get)
+{
+    DBConnector db("TEST_DB", 0, true);
+    clearDB();
+    Table table(&db, "BATCHED_GET_UT_TEST");
+
+    table.set("a", { {"f1", "1"}, {"f2", "2"} });
+    table.set("c", { {"f1", "3"} });
+
+    vector<pair<bool, vector<FieldValueTuple>>> entries;
+    table.get({ "a", "b", "c" }, entries);
+    ASSERT_EQ(entries.size(), 3UL);
+    EXPECT_TRUE(entries[0].first);
+    EXPECT_EQ(entries[0].second.size(), 2UL);
+    EXPECT_FALSE(entries[1].first);
+    EXPECT_TRUE(entries[1].second.empty());
+    EXPECT_TRUE(entries[2].first);
+    EXPECT_EQ(*fvsGetValue(entries[2].second, "f1"), "3");
+
+    vector<pair<bool, string>> values;
+    table.hget({ "a", "b", "c" }, "f2", values);
+    ASSERT_EQ(values.size(), 3UL);
+    EXPECT_TRUE(values[0].first);
+    EXPECT_EQ(values[0].second, "2");
+    EXPECT_FALSE(values[1].first);
+    EXPECT_FALSE(values[2].first);
+
+    vector<KeyOpFieldsValuesTuple> tuples;
+    table.getContent(tuples);
+    ASSERT_EQ(tuples.size(), 2UL);
+    for (const auto &tuple : tuples)
+    {
+        EXPECT_EQ(kfvFieldsValues(tuple).size(), kfvKey(tuple) == "a" ? 2UL : 1UL);
+    }
+}
+
+TEST(Table, for_each_entry)
+{
+    DBConnector db("TEST_DB", 0, true);
+    clearDB();
+    Table table(&db, "SCAN_UT_TEST");
+    Table other(&db, "SCAN_UT_TEST_OTHER");
+
+    for (int i = 0; i < 100; i++)
+    {
+        table.set("key" + to_string(i), { {"field", to_string(i)} });
+    }
+    other.set("key0", { {"field", "other"} });
+
+    // A small SCAN count forces many incremental batches
+    map<string, string> seen;
+    size_t calls = 0;
+    table.forEachEntry([&](const string &key, const vector<FieldValueTuple> &values) {
+        calls++;
+        ASSERT_EQ(values.size(), 1UL);
+        seen[key] = fvValue(values[0]);
+    }, 7);
+
+    EXPECT_GE(calls, 100UL);
+    ASSERT_EQ(seen.size(), 100UL);
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(seen["key" + to_string(i)], to_string(i));
+    }
+
+    vector<string> keys;
+    size_t total = 0;
+    uint64_t cursor = 0;
+    do
+    {
+        cursor = table.scanKeys(cursor, keys, 10);
+        total += keys.size();
+    } while (cursor != 0);
+    EXPECT_GE(total, 100UL);
+}
+
+TEST(Table, dump)
+{
+    DBConnector db("TEST_DB", 0, true);
+    clearDB();
+    Table table(&db, "DUMP_UT_TEST");
+
+    const string binary("\x00\x01\"{}", 5);
+    for (int i = 0; i < 50; i++)
+    {
+        table.set("key" + to_string(i), { {"field", to_string(i)}, {"binary", binary} });
+    }
+    table.set("empty", { {"NULL", "NULL"} });
+
+    TableDump atomic;
+    table.dump(atomic);
+    ASSERT_EQ(atomic.size(), 51UL);
+    EXPECT_EQ(atomic["key7"]["field"], "7");
+    EXPECT_EQ(atomic["key7"]["binary"], binary);
+    EXPECT_TRUE(atomic["empty"].empty());
+
+    TableDump chunked;
+    table.setDumpChunkSize(5);
+    table.dump(chunked);
+    EXPECT_EQ(chunked, atomic);
+}
+
 TEST(ProducerConsumer, Prefix)
 {
     std::string tableName = "tableName";
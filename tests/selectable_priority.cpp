@@ -247,3 +247,227 @@ TEST(Priority, priority_select_6)
     // we gave fair scheduler. we've read different selectables on the second read
     EXPECT_NE(selectcs1, selectcs2);
 }
+
+// An event with a backlog of messages, like a flooded table
+class FloodingEvent : public SelectableEvent
+{
+public:
+    FloodingEvent(int pri, int messages) : SelectableEvent(pri), m_messages(messages) {}
+
+    bool hasData() override
+    {
+        return m_messages > 0;
+    }
+
+    bool hasCachedData() override
+    {
+        return m_messages > 1;
+    }
+
+    void updateAfterRead() override
+    {
+        m_messages--;
+    }
+
+private:
+    int m_messages;
+};
+
+TEST(Priority, select_many)
+{
+    Select cs;
+    std::vector<Selectable *> selectables;
+
+    FloodingEvent flood(1000, 3);
+    SelectableEvent s1(100);
+    SelectableEvent s2(10);
+
+    cs.addSelectable(&s1);
+    cs.addSelectable(&flood);
+    cs.addSelectable(&s2);
+
+    flood.notify();
+    s1.notify();
+    s2.notify();
+
+    // Every ready Selectable once, by priority
+    int ret = cs.selectMany(selectables, 1000);
+    EXPECT_EQ(ret, Select::OBJECT);
+    EXPECT_EQ(selectables, (std::vector<Selectable *>{ &flood, &s1, &s2 }));
+
+    // The flood is back for its cached messages
+    ret = cs.selectMany(selectables, 1000);
+    EXPECT_EQ(ret, Select::OBJECT);
+    EXPECT_EQ(selectables, (std::vector<Selectable *>{ &flood }));
+
+    ret = cs.selectMany(selectables, 1000);
+    EXPECT_EQ(ret, Select::OBJECT);
+    EXPECT_EQ(selectables, (std::vector<Selectable *>{ &flood }));
+
+    ret = cs.selectMany(selectables, 10);
+    EXPECT_EQ(ret, Select::TIMEOUT);
+    EXPECT_TRUE(selectables.empty());
+}
+
+TEST(Priority, time_budget)
+{
+    Select cs;
+    Selectable *selectcs;
+
+    FloodingEvent flood(1000, 100);
+    SelectableEvent timer(0);
+
+    cs.addSelectable(&flood);
+    cs.addSelectable(&timer);
+
+    flood.notify();
+    timer.notify();
+
+    // Without a budget the flood starves the low priority timer
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+        EXPECT_EQ(selectcs, &flood);
+    }
+
+    // Once the flood spent its budget the timer goes first
+    flood.setTimeBudget(std::chrono::microseconds(1000));
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &flood);
+    usleep(2000);
+
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &timer);
+
+    // Nothing else is ready, a new round starts
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &flood);
+    EXPECT_FALSE(cs.isQueueEmpty());
+}
+
+TEST(Priority, select_stats)
+{
+    Select cs;
+    Selectable *selectcs;
+
+    FloodingEvent flood(1000, 3);
+    SelectableEvent s1(100);
+
+    cs.addSelectable(&flood);
+    cs.addSelectable(&s1);
+    cs.enableStats(true);
+
+    flood.notify();
+    s1.notify();
+
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    }
+    EXPECT_EQ(cs.select(&selectcs, 10), Select::TIMEOUT);
+
+    auto stats = cs.getStats(&flood);
+    EXPECT_EQ(stats.dispatches, 3UL);
+    EXPECT_EQ(stats.requeues, 2UL);
+    EXPECT_EQ(stats.readDataCalls, 1UL);
+    uint64_t histogramCount = 0;
+    for (auto count : stats.latencyHistogram)
+    {
+        histogramCount += count;
+    }
+    EXPECT_EQ(histogramCount, 3UL);
+    EXPECT_GE(stats.maxLatencyNs * 3, stats.totalLatencyNs);
+
+    EXPECT_EQ(cs.getStats(&s1).dispatches, 1UL);
+    EXPECT_EQ(cs.getStats(&s1).requeues, 0UL);
+
+    DBConnector db("STATE_DB", 0, true);
+    Table table(&db, "SELECT_STATS_UT");
+    cs.writeStats(table);
+    std::string value;
+    ASSERT_TRUE(table.hget("fd" + std::to_string(flood.getFd()), "dispatches", value));
+    EXPECT_EQ(value, "3");
+    ASSERT_TRUE(table.hget("fd" + std::to_string(s1.getFd()), "priority", value));
+    EXPECT_EQ(value, "100");
+    table.del("fd" + std::to_string(flood.getFd()));
+    table.del("fd" + std::to_string(s1.getFd()));
+
+    cs.enableStats(false);
+    EXPECT_EQ(cs.getStats(&flood).dispatches, 0UL);
+}
+
+TEST(Priority, pause_selectable)
+{
+    for (auto backend : { Select::Backend::EPOLL, Select::Backend::IO_URING })
+    {
+        Select cs(backend);
+        Selectable *selectcs;
+
+        FloodingEvent flood(1000, 3);
+        SelectableEvent s1(100);
+
+        cs.addSelectable(&flood);
+        cs.addSelectable(&s1);
+        cs.enableStats(true);
+
+        flood.notify();
+        EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+        EXPECT_EQ(selectcs, &flood);
+        EXPECT_TRUE(cs.isRequeued(&flood));
+        EXPECT_FALSE(cs.isRequeued(&s1));
+
+        // Neither its cached data nor its fd is selected while paused
+        cs.pauseSelectable(&flood);
+        EXPECT_FALSE(cs.isRequeued(&flood));
+        flood.notify();
+        s1.notify();
+        EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+        EXPECT_EQ(selectcs, &s1);
+        EXPECT_EQ(cs.select(&selectcs, 10), Select::TIMEOUT);
+
+        // Resumed with its stats
+        cs.resumeSelectable(&flood);
+        EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+        EXPECT_EQ(selectcs, &flood);
+        EXPECT_EQ(cs.getStats(&flood).dispatches, 2UL);
+        EXPECT_EQ(cs.getStats(&flood).readDataCalls, 2UL);
+    }
+}
+
+TEST(Priority, io_uring_backend)
+{
+    Select cs(Select::Backend::IO_URING);
+    if (cs.getBackend() != Select::Backend::IO_URING)
+    {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    Selectable *selectcs;
+
+    SelectableEvent s1(100);
+    SelectableEvent s2(1000);
+
+    cs.addSelectable(&s1);
+    cs.addSelectable(&s2);
+    EXPECT_EQ(cs.select(&selectcs, 10), Select::TIMEOUT);
+
+    s1.notify();
+    s2.notify();
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &s2);
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &s1);
+    EXPECT_EQ(cs.select(&selectcs, 10), Select::TIMEOUT);
+
+    // The polls are re-armed
+    s1.notify();
+    EXPECT_EQ(cs.select(&selectcs), Select::OBJECT);
+    EXPECT_EQ(selectcs, &s1);
+
+    cs.removeSelectable(&s2);
+    s2.notify();
+    EXPECT_EQ(cs.select(&selectcs, 10), Select::TIMEOUT);
+
+    cs.addSelectable(&s2);
+    EXPECT_EQ(cs.select(&selectcs, 10), Select::OBJECT);
+    EXPECT_EQ(selectcs, &s2);
+}
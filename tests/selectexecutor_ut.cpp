@@ -0,0 +1,196 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include "common/selectexecutor.h"
+#include "common/selectableevent.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace swss;
+
+// Counts the handled reads and the handlers running at once
+class HandlerTracker
+{
+public:
+    void enter()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running++;
+        m_maxRunning = max(m_maxRunning, m_running);
+        m_threads.insert(this_thread::get_id());
+    }
+
+    void leave(Selectable *selectable)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running--;
+        m_order.push_back(selectable);
+        m_cv.notify_all();
+    }
+
+    bool waitHandled(size_t count)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        return m_cv.wait_for(lock, chrono::seconds(5), [&] { return m_order.size() >= count; });
+    }
+
+    SelectExecutor::Handler handler(chrono::milliseconds duration = chrono::milliseconds(0))
+    {
+        return [this, duration](Selectable *selectable) {
+            enter();
+            this_thread::sleep_for(duration);
+            leave(selectable);
+        };
+    }
+
+    mutex m_mutex;
+    condition_variable m_cv;
+    int m_running = 0;
+    int m_maxRunning = 0;
+    set<thread::id> m_threads;
+    vector<Selectable *> m_order;
+};
+
+// An event with a backlog of messages
+class BacklogEvent : public SelectableEvent
+{
+public:
+    BacklogEvent(int messages) : m_messages(messages) {}
+
+    bool hasData() override
+    {
+        return m_messages > 0;
+    }
+
+    bool hasCachedData() override
+    {
+        return m_messages > 1;
+    }
+
+    void updateAfterRead() override
+    {
+        m_messages--;
+    }
+
+    int m_messages;
+};
+
+TEST(SelectExecutor, parallel)
+{
+    SelectExecutor executor(4);
+    HandlerTracker tracker;
+    SelectableEvent events[4];
+    for (auto &event : events)
+    {
+        executor.addSelectable(&event, tracker.handler(chrono::milliseconds(100)));
+    }
+
+    executor.start();
+    for (auto &event : events)
+    {
+        event.notify();
+    }
+    ASSERT_TRUE(tracker.waitHandled(4));
+    EXPECT_GT(tracker.m_maxRunning, 1);
+
+    // Handled events are watched again
+    events[0].notify();
+    ASSERT_TRUE(tracker.waitHandled(5));
+    EXPECT_EQ(tracker.m_order.back(), &events[0]);
+    executor.stop();
+}
+
+TEST(SelectExecutor, group)
+{
+    SelectExecutor executor(4);
+    HandlerTracker tracker;
+    HandlerTracker other;
+    SelectableEvent events[3];
+    SelectableEvent independent;
+    for (auto &event : events)
+    {
+        executor.addSelectable(&event, tracker.handler(chrono::milliseconds(20)), 1);
+    }
+    executor.addSelectable(&independent, other.handler());
+
+    executor.start();
+    for (int i = 0; i < 3; i++)
+    {
+        for (auto &event : events)
+        {
+            event.notify();
+        }
+        independent.notify();
+        ASSERT_TRUE(tracker.waitHandled(3 * (i + 1)));
+        ASSERT_TRUE(other.waitHandled(i + 1));
+    }
+    executor.stop();
+
+    EXPECT_EQ(tracker.m_maxRunning, 1);
+}
+
+TEST(SelectExecutor, affinity)
+{
+    SelectExecutor executor(3);
+    HandlerTracker tracker;
+    SelectableEvent event;
+    executor.addSelectable(&event, tracker.handler(), SelectExecutor::NO_GROUP, 2);
+    EXPECT_THROW(executor.addSelectable(&event, tracker.handler(), SelectExecutor::NO_GROUP, 3), runtime_error);
+
+    executor.start();
+    EXPECT_THROW(executor.removeSelectable(&event), runtime_error);
+    for (size_t i = 1; i <= 10; i++)
+    {
+        event.notify();
+        ASSERT_TRUE(tracker.waitHandled(i));
+    }
+    executor.stop();
+
+    EXPECT_EQ(tracker.m_threads.size(), 1UL);
+}
+
+TEST(SelectExecutor, cached)
+{
+    SelectExecutor executor(2);
+    HandlerTracker tracker;
+    BacklogEvent backlog(5);
+    executor.addSelectable(&backlog, tracker.handler());
+
+    executor.start();
+    backlog.notify();
+    ASSERT_TRUE(tracker.waitHandled(5));
+    executor.stop();
+
+    EXPECT_EQ(backlog.m_messages, 0);
+    EXPECT_EQ(tracker.m_order.size(), 5UL);
+
+    // Handled after a restart
+    executor.removeSelectable(&backlog);
+    backlog.m_messages = 2;
+    executor.addSelectable(&backlog, tracker.handler());
+    backlog.notify();
+    executor.start();
+    ASSERT_TRUE(tracker.waitHandled(7));
+    executor.stop();
+}
+
+TEST(SelectExecutor, stats)
+{
+    SelectExecutor executor(2);
+    HandlerTracker tracker;
+    SelectableEvent event;
+    executor.addSelectable(&event, tracker.handler());
+    executor.m_select.enableStats(true);
+
+    // The Selectable is paused in the Select while handled, its stats are kept
+    executor.start();
+    for (size_t i = 1; i <= 3; i++)
+    {
+        event.notify();
+        ASSERT_TRUE(tracker.waitHandled(i));
+    }
+    executor.stop();
+
+    EXPECT_EQ(executor.m_select.getStats(&event).dispatches, 3UL);
+}
@@ -3,6 +3,14 @@
 #include <thread>
 #include <algorithm>
 #include <deque>
+#include <list>
+#include <queue>
+#include <set>
+#include <mutex>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
 #include <zmq.hpp>
 #include "gtest/gtest.h"
 #include "common/dbconnector.h"
@@ -13,9 +21,11 @@
 #include "common/table.h"
 #include "common/zmqserver.h"
 #include "common/zmqclient.h"
+#include "common/zmqshm.h"
 #include "common/zmqproducerstatetable.h"
 #include "common/zmqconsumerstatetable.h"
 #include "common/binaryserializer.h"
+#include "common/asyncdbupdater.h"
 
 using namespace std;
 using namespace swss;
@@ -434,20 +444,41 @@ TEST(ZmqProducerStateTableBatch, test)
 
 TEST(ZmqConsumerStateTableBatchBufferOverflow, test)
 {
-    std::string testTableName = "ZMQ_PROD_CONS_UT";
-    std::string pushEndpoint = "tcp://localhost:1234";
+    std::string testTableName = "ZMQ_LARGE_BATCH_UT";
+    std::string pushEndpoint = "tcp://localhost:1237";
+    std::string pullEndpoint = "tcp://*:1237";
 
     DBConnector db(TEST_DB, 0, true);
+    ZmqServer server(pullEndpoint);
+    ZmqConsumerStateTable c(&db, testTableName, server, 128, 0, false);
     ZmqClient client(pushEndpoint);
-    ZmqProducerStateTable p(&db, testTableName, client, true);
+    ZmqProducerStateTable p(&db, testTableName, client, false);
 
-    // Send a large message and expect exception thrown.
+    // A batch larger than MQ_RESPONSE_MAX_COUNT is sent as a single message.
+    const string largeValue(1024 * 1024, 'x');
     std::vector<KeyOpFieldsValuesTuple> kcos;
-    for (int i = 0; i <= MQ_RESPONSE_MAX_COUNT; i++)
+    for (int i = 0; i < 20; i++)
+    {
+        kcos.push_back(KeyOpFieldsValuesTuple("key" + to_string(i), SET_COMMAND, vector<FieldValueTuple>{ {"field", largeValue} }));
+    }
+    EXPECT_GT(BinarySerializer::serializedSize(TEST_DB, testTableName, kcos), (size_t)MQ_RESPONSE_MAX_COUNT);
+    p.send(kcos);
+
+    Select cs;
+    cs.addSelectable(&c);
+    Selectable *selectcs;
+    std::deque<KeyOpFieldsValuesTuple> vkco;
+    size_t received = 0;
+    while (received < kcos.size() && cs.select(&selectcs, 10000) == Select::OBJECT)
     {
-        kcos.push_back(KeyOpFieldsValuesTuple("key", DEL_COMMAND, vector<FieldValueTuple>{}));
+        c.pops(vkco);
+        for (auto &kco : vkco)
+        {
+            EXPECT_EQ(kfvFieldsValues(kco), kfvFieldsValues(kcos[received]));
+            received++;
+        }
     }
-    EXPECT_ANY_THROW(p.send(kcos));
+    EXPECT_EQ(received, kcos.size());
 }
 
 TEST(ZmqProducerStateTableDeleteAfterSend, test)
@@ -493,21 +524,14 @@ static void zmqConsumerWorker(string tableName, string endpoint,
 
   while (!zmq_done) {
     sleep(2);
-    std::string recDbName, recTableName;
-    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> recKcos;
-    std::vector<KeyOpFieldsValuesTuple> deserializedKcos;
-
-    BinarySerializer::deserializeBuffer(server.m_buffer.data(),
-                                        server.m_buffer.size(), recDbName,
-                                        recTableName, recKcos);
+    std::deque<KeyOpFieldsValuesTuple> vkco;
+    c.pops(vkco);
 
-    for (auto kcoPtr : recKcos)
+    EXPECT_FALSE(vkco.empty());
+    for (auto &kco : vkco)
     {
-      deserializedKcos.push_back(*kcoPtr);
+      EXPECT_EQ(kco, values.front());
     }
-    EXPECT_EQ(recDbName, TEST_DB);
-    EXPECT_EQ(recTableName, tableName);
-    EXPECT_EQ(deserializedKcos, values);
     }
 
     allDataReceived = true;
@@ -703,3 +727,776 @@ INSTANTIATE_TEST_CASE_P(
         PopSizeTestParams{-1, 384, 3, {128, 128, 128}}
     )
 );
+
+static vector<vector<shared_ptr<KeyOpFieldsValuesTuple>>> createReceivedBatches(int batches, int batchSize)
+{
+    vector<vector<shared_ptr<KeyOpFieldsValuesTuple>>> result(batches);
+    for (int i = 0; i < batches; i++)
+    {
+        for (int j = 0; j < batchSize; j++)
+        {
+            result[i].push_back(make_shared<KeyOpFieldsValuesTuple>(
+                "key_" + to_string(j), SET_COMMAND, vector<FieldValueTuple>{ {"field", "value"} }));
+        }
+    }
+    return result;
+}
+
+// Microbenchmark of the hand over between the ZMQ poll thread and the
+// consumer, run with --gtest_also_run_disabled_tests
+TEST(ZmqConsumerStateTableQueue, DISABLED_throughput)
+{
+    const int batches = 2000;
+    const int batchSize = 128;
+    const size_t total = batches * batchSize;
+
+    // Baseline: the lock is taken on every access of the queue
+    double baselineRate;
+    {
+        auto received = createReceivedBatches(batches, batchSize);
+        mutex m;
+        queue<shared_ptr<KeyOpFieldsValuesTuple>, list<shared_ptr<KeyOpFieldsValuesTuple>>> q;
+
+        auto start = chrono::steady_clock::now();
+        thread producer([&]() {
+            for (auto &batch : received)
+            {
+                for (auto &kco : batch)
+                {
+                    lock_guard<mutex> lock(m);
+                    q.push(kco);
+                }
+            }
+        });
+
+        size_t popped = 0;
+        deque<KeyOpFieldsValuesTuple> vkco;
+        while (popped < total)
+        {
+            vkco.clear();
+            while (vkco.size() < (size_t)batchSize)
+            {
+                lock_guard<mutex> lock(m);
+                if (q.empty())
+                {
+                    break;
+                }
+                vkco.push_back(*q.front());
+                q.pop();
+            }
+            popped += vkco.size();
+        }
+        producer.join();
+        baselineRate = (double)total / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    // ZmqConsumerStateTable: one lock per received batch and per drained queue
+    double tableRate;
+    {
+        auto received = createReceivedBatches(batches, batchSize);
+        DBConnector db(TEST_DB, 0, true);
+        // never bound, the batches are handed over directly
+        ZmqServer server("tcp://*:1236", "", true);
+        ZmqConsumerStateTable c(&db, "ZMQ_QUEUE_BENCH_UT", server, batchSize, 0, false);
+
+        auto start = chrono::steady_clock::now();
+        thread producer([&]() {
+            for (auto &batch : received)
+            {
+                c.handleReceivedData(batch);
+            }
+        });
+
+        size_t popped = 0;
+        deque<KeyOpFieldsValuesTuple> vkco;
+        while (popped < total)
+        {
+            vkco.clear();
+            c.pops(vkco);
+            popped += vkco.size();
+        }
+        producer.join();
+        tableRate = (double)total / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        EXPECT_EQ(popped, total);
+        EXPECT_FALSE(c.hasData());
+    }
+
+    cout << "Per operation locking: " << (uint64_t)baselineRate << " ops/s" << endl;
+    cout << "Batch swap queue:      " << (uint64_t)tableRate << " ops/s" << endl;
+}
+
+// The poll thread hands over batches while the consumer pops
+TEST(ZmqConsumerStateTableQueue, handover)
+{
+    const int batches = 200;
+    const int batchSize = 16;
+    const int popBatchSize = 24;
+
+    vector<vector<shared_ptr<KeyOpFieldsValuesTuple>>> received(batches);
+    for (int i = 0; i < batches; i++)
+    {
+        for (int j = 0; j < batchSize; j++)
+        {
+            received[i].push_back(make_shared<KeyOpFieldsValuesTuple>(
+                "key_" + to_string(i * batchSize + j), SET_COMMAND, vector<FieldValueTuple>{ {"field", to_string(j)} }));
+        }
+    }
+
+    DBConnector db(TEST_DB, 0, true);
+    // never bound, the batches are handed over directly
+    ZmqServer server("tcp://*:1236", "", true);
+    ZmqConsumerStateTable c(&db, "ZMQ_QUEUE_UT", server, popBatchSize, 0, false);
+
+    thread producer([&]() {
+        for (auto &batch : received)
+        {
+            c.handleReceivedData(batch);
+        }
+    });
+
+    int popped = 0;
+    deque<KeyOpFieldsValuesTuple> vkco;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+    while (popped < batches * batchSize && chrono::steady_clock::now() < deadline)
+    {
+        vkco.clear();
+        c.pops(vkco);
+        EXPECT_LE(vkco.size(), (size_t)popBatchSize);
+        for (auto &kco : vkco)
+        {
+            // in order, none lost or duplicated
+            EXPECT_EQ(kfvKey(kco), "key_" + to_string(popped));
+            EXPECT_EQ(fvValue(kfvFieldsValues(kco)[0]), to_string(popped % batchSize));
+            popped++;
+        }
+    }
+    producer.join();
+
+    // The caller's tuples are copied, not emptied
+    EXPECT_EQ(kfvKey(*received.back().back()), "key_" + to_string(batches * batchSize - 1));
+    EXPECT_EQ(kfvFieldsValues(*received.back().back()).size(), 1UL);
+
+    EXPECT_EQ(popped, batches * batchSize);
+    vkco.clear();
+    c.pops(vkco);
+    EXPECT_TRUE(vkco.empty());
+    EXPECT_FALSE(c.hasData());
+}
+
+TEST(AsyncDBUpdater, coalesce)
+{
+    std::string testTableName = "ASYNC_DB_UPDATER_UT";
+    DBConnector db(TEST_DB, 0, true);
+    Table table(&db, testTableName);
+    table.del("k1");
+    table.del("k2");
+    table.set("k3", { {"stale", "1"} });
+
+    {
+        AsyncDBUpdater updater(&db, testTableName);
+        updater.setMaxQueueSize(16);
+
+        for (int i = 0; i < 1000; i++)
+        {
+            updater.update(make_shared<KeyOpFieldsValuesTuple>(
+                "k1", SET_COMMAND, vector<FieldValueTuple>{ {"f" + to_string(i % 2), to_string(i)} }));
+        }
+        updater.update(make_shared<KeyOpFieldsValuesTuple>("k2", SET_COMMAND, vector<FieldValueTuple>{ {"f", "v"} }));
+        updater.update(make_shared<KeyOpFieldsValuesTuple>("k2", DEL_COMMAND, vector<FieldValueTuple>{}));
+        updater.update({
+            make_shared<KeyOpFieldsValuesTuple>("k3", SET_COMMAND, vector<FieldValueTuple>{ {"fresh", "2"} }),
+        });
+
+        while (updater.queueSize() > 0)
+        {
+            usleep(10 * 1000);
+        }
+    }
+
+    // The last SET replaces the whole entry
+    vector<FieldValueTuple> values;
+    ASSERT_TRUE(table.get("k1", values));
+    EXPECT_EQ(values, (vector<FieldValueTuple>{ {"f1", "999"} }));
+    EXPECT_FALSE(table.get("k2", values));
+    ASSERT_TRUE(table.get("k3", values));
+    EXPECT_EQ(values, (vector<FieldValueTuple>{ {"fresh", "2"} }));
+}
+
+static void popAll(ZmqConsumerStateTable &c, size_t count, vector<KeyOpFieldsValuesTuple> &received)
+{
+    Select cs;
+    cs.addSelectable(&c);
+    Selectable *selectcs;
+    std::deque<KeyOpFieldsValuesTuple> vkco;
+    while (received.size() < count && cs.select(&selectcs, 5000) == Select::OBJECT)
+    {
+        vkco.clear();
+        c.pops(vkco);
+        received.insert(received.end(), vkco.begin(), vkco.end());
+    }
+}
+
+TEST(ZmqClientAsyncSend, test)
+{
+    std::string testTableName = "ZMQ_ASYNC_SEND_UT";
+    DBConnector db(TEST_DB, 0, true);
+    ZmqServer server("tcp://*:1238");
+    ZmqConsumerStateTable c(&db, testTableName, server, 128, 0, false);
+    ZmqClient client("tcp://localhost:1238");
+
+    auto set = [](const string &key, vector<FieldValueTuple> fvs) {
+        return KeyOpFieldsValuesTuple(key, SET_COMMAND, fvs);
+    };
+    auto del = [](const string &key) {
+        return KeyOpFieldsValuesTuple(key, DEL_COMMAND, vector<FieldValueTuple>());
+    };
+
+    // The operations of one sendMsg() are queued at once, the oldest overflow
+    client.enableAsyncSend(3, ZmqClient::OverflowPolicy::DROP_OLDEST);
+    client.sendMsg(TEST_DB, testTableName, { set("k1", { {"f", "1"} }), set("k2", { {"f", "1"} }),
+                                             set("k3", { {"f", "1"} }), set("k4", { {"f", "1"} }) });
+    EXPECT_TRUE(client.waitDrained(5000));
+    EXPECT_EQ(client.getQueueDepth(), 0UL);
+    EXPECT_EQ(client.getDroppedCount(), 1UL);
+    EXPECT_EQ(client.getSendErrorCount(), 0UL);
+
+    vector<KeyOpFieldsValuesTuple> received;
+    popAll(c, 3, received);
+    EXPECT_EQ(received, (vector<KeyOpFieldsValuesTuple>{ set("k2", { {"f", "1"} }), set("k3", { {"f", "1"} }), set("k4", { {"f", "1"} }) }));
+
+    // Fields merge, a DEL drops the earlier SETs, a SET after a DEL recreates the key
+    client.enableAsyncSend(100, ZmqClient::OverflowPolicy::COALESCE);
+    client.sendMsg(TEST_DB, testTableName, { set("k1", { {"a", "1"}, {"b", "1"} }), set("k2", { {"f", "1"} }), set("k1", { {"b", "2"}, {"c", "2"} }),
+                                             del("k3"), set("k3", { {"f", "3"} }),
+                                             set("k4", { {"f", "4"} }), del("k4") });
+    EXPECT_TRUE(client.waitDrained(5000));
+    EXPECT_EQ(client.getCoalescedCount(), 3UL);
+
+    received.clear();
+    popAll(c, 5, received);
+    EXPECT_EQ(received, (vector<KeyOpFieldsValuesTuple>{
+        set("k1", { {"a", "1"}, {"b", "2"}, {"c", "2"} }),
+        set("k2", { {"f", "1"} }),
+        del("k3"),
+        set("k3", { {"f", "3"} }),
+        del("k4") }));
+}
+
+class SlowZmqHandler : public ZmqMessageHandler
+{
+public:
+    SlowZmqHandler(int delayMs) : m_delayMs(delayMs) {}
+
+    void handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>& kcos) override
+    {
+        usleep(m_delayMs * 1000);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &kco : kcos)
+        {
+            m_keys.push_back(kfvKey(*kco));
+        }
+    }
+
+    vector<string> keys()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_keys;
+    }
+
+private:
+    int m_delayMs;
+    std::mutex m_mutex;
+    vector<string> m_keys;
+};
+
+TEST(ZmqServerDispatchThreads, test)
+{
+    ZmqServer server("tcp://*:1239", "", false, 2);
+    SlowZmqHandler slow(200);
+    SlowZmqHandler fast(0);
+    server.registerMessageHandler(TEST_DB, "SLOW_TABLE", &slow);
+    server.registerMessageHandler(TEST_DB, "FAST_TABLE", &fast);
+
+    ZmqClient client("tcp://localhost:1239");
+    for (int i = 0; i < 5; i++)
+    {
+        client.sendMsg(TEST_DB, "SLOW_TABLE", { KeyOpFieldsValuesTuple("slow" + to_string(i), DEL_COMMAND, {}) });
+        client.sendMsg(TEST_DB, "FAST_TABLE", { KeyOpFieldsValuesTuple("fast" + to_string(i), DEL_COMMAND, {}) });
+    }
+
+    // The fast table is not delayed by the slow one on the other worker
+    for (int i = 0; i < 100 && fast.keys().size() < 5; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(fast.keys(), (vector<string>{ "fast0", "fast1", "fast2", "fast3", "fast4" }));
+    EXPECT_LT(slow.keys().size(), 5UL);
+
+    // Every table keeps its order
+    for (int i = 0; i < 300 && slow.keys().size() < 5; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(slow.keys(), (vector<string>{ "slow0", "slow1", "slow2", "slow3", "slow4" }));
+}
+
+TEST(ZmqServerResponse, test)
+{
+    ZmqServer server("tcp://*:1240", "", false, 0, true);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "RESPONSE_TABLE", &handler);
+
+    ZmqClient client("tcp://localhost:1240", 3000, true);
+
+    // Pipeline several batches before collecting any response
+    for (int i = 0; i < 3; i++)
+    {
+        client.sendMsg(TEST_DB, "RESPONSE_TABLE", { KeyOpFieldsValuesTuple("k" + to_string(i), DEL_COMMAND, {}) });
+    }
+    EXPECT_EQ(client.getLastRequestId(), 3UL);
+    EXPECT_EQ(client.getOutstandingRequestCount(), 3UL);
+
+    for (int i = 0; i < 300 && handler.keys().size() < 3; i++)
+    {
+        usleep(10 * 1000);
+    }
+    ASSERT_EQ(handler.keys().size(), 3UL);
+
+    // One response acks all the batches
+    server.sendMsg(TEST_DB, "RESPONSE_TABLE", { KeyOpFieldsValuesTuple("k2", SET_COMMAND, { FieldValueTuple("status", "0") }) });
+
+    std::string dbName, tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    uint64_t requestId = 0;
+    ASSERT_TRUE(client.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 3UL);
+    EXPECT_EQ(dbName, TEST_DB);
+    EXPECT_EQ(tableName, "RESPONSE_TABLE");
+    ASSERT_EQ(kcos.size(), 1UL);
+    EXPECT_EQ(kfvKey(*kcos[0]), "k2");
+    EXPECT_EQ(kfvFieldsValues(*kcos[0]), (vector<FieldValueTuple>{ FieldValueTuple("status", "0") }));
+    EXPECT_EQ(client.getLastAckedRequestId(), 3UL);
+    EXPECT_EQ(client.getOutstandingRequestCount(), 0UL);
+
+    // No more response, wait times out
+    EXPECT_FALSE(client.wait(dbName, tableName, kcos, requestId, 100));
+}
+
+TEST(ZmqServerResponse, clients)
+{
+    DBConnector db(TEST_DB, 0, true);
+    ZmqServer server("tcp://*:1240", "", false, 0, true);
+    ZmqConsumerStateTable c(&db, "RESPONSE_QUEUE_TABLE", server, 1);
+
+    ZmqClient first("tcp://localhost:1240", 3000, true);
+    ZmqClient second("tcp://localhost:1240", 3000, true);
+    auto del = [](const string& key) {
+        return std::vector<KeyOpFieldsValuesTuple>{ KeyOpFieldsValuesTuple(key, DEL_COMMAND, {}) };
+    };
+    auto popKey = [&c]() {
+        std::deque<KeyOpFieldsValuesTuple> vkco;
+        for (int i = 0; i < 300 && vkco.empty(); i++)
+        {
+            c.pops(vkco);
+            if (vkco.empty())
+            {
+                usleep(10 * 1000);
+            }
+        }
+        return vkco.empty() ? string() : kfvKey(vkco.front());
+    };
+    std::vector<KeyOpFieldsValuesTuple> status = { KeyOpFieldsValuesTuple("k", SET_COMMAND, { FieldValueTuple("status", "0") }) };
+
+    first.sendMsg(TEST_DB, "RESPONSE_QUEUE_TABLE", del("a1"));
+    first.sendMsg(TEST_DB, "RESPONSE_QUEUE_TABLE", del("a2"));
+    EXPECT_EQ(popKey(), "a1");
+    second.sendMsg(TEST_DB, "RESPONSE_QUEUE_TABLE", del("b1"));
+
+    // Only the popped request is acked, received ones are still queued
+    server.sendMsg(TEST_DB, "RESPONSE_QUEUE_TABLE", status);
+    std::string dbName, tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    uint64_t requestId = 0;
+    ASSERT_TRUE(first.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 1UL);
+    EXPECT_EQ(first.getOutstandingRequestCount(), 1UL);
+    EXPECT_FALSE(second.wait(dbName, tableName, kcos, requestId, 100));
+
+    // Every client gets the response of its own requests
+    std::set<string> keys = { popKey(), popKey() };
+    EXPECT_EQ(keys, (std::set<string>{ "a2", "b1" }));
+    server.sendMsg(TEST_DB, "RESPONSE_QUEUE_TABLE", status);
+    ASSERT_TRUE(first.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 2UL);
+    ASSERT_TRUE(second.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 1UL);
+    EXPECT_EQ(first.getOutstandingRequestCount(), 0UL);
+    EXPECT_EQ(second.getOutstandingRequestCount(), 0UL);
+}
+
+class RespondingZmqHandler : public ZmqMessageHandler
+{
+public:
+    RespondingZmqHandler(ZmqServer& server) : m_server(server) {}
+
+    void handleReceivedData(const std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>>&) override
+    {
+    }
+
+    bool handleReceivedMessage(std::shared_ptr<const KcoViewMessage> message) override
+    {
+        m_server.sendMsg(*message, { KeyOpFieldsValuesTuple(message->kcos.front().key.str(), SET_COMMAND, {}) });
+        return true;
+    }
+
+private:
+    ZmqServer& m_server;
+};
+
+TEST(ZmqServerResponse, request)
+{
+    ZmqServer server("tcp://*:1240", "", false, 2, true);
+    RespondingZmqHandler handler(server);
+    server.registerMessageHandler(TEST_DB, "RESPONSE_TABLE", &handler);
+
+    // Responses of the dispatch workers go to the request they handled
+    ZmqClient client("tcp://localhost:1240", 3000, true);
+    for (int i = 1; i <= 3; i++)
+    {
+        client.sendMsg(TEST_DB, "RESPONSE_TABLE", { KeyOpFieldsValuesTuple("k" + to_string(i), DEL_COMMAND, {}) });
+    }
+
+    std::string dbName, tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    uint64_t requestId = 0;
+    for (uint64_t i = 1; i <= 3; i++)
+    {
+        ASSERT_TRUE(client.wait(dbName, tableName, kcos, requestId, 3000));
+        EXPECT_EQ(requestId, i);
+        ASSERT_EQ(kcos.size(), 1UL);
+        EXPECT_EQ(kfvKey(*kcos[0]), "k" + to_string(i));
+    }
+}
+
+TEST(ZmqCompressor, roundtrip)
+{
+    std::string data;
+    for (int i = 0; i < 100; i++)
+    {
+        data += "SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID=oid:0x40000000" + to_string(i) + ";";
+    }
+
+    for (auto codec : { ZmqCompression::LZ4, ZmqCompression::ZSTD })
+    {
+        ZmqCompressionStats stats;
+        std::vector<char> compressed(ZmqCompressor::compressBound(codec, data.size()));
+        size_t size = ZmqCompressor::compress(codec, data.data(), data.size(), compressed.data(), compressed.size(), stats);
+        ASSERT_GT(size, 0UL);
+        EXPECT_LT(size, data.size());
+
+        std::string output(ZmqCompressor::decompressedSize(compressed.data(), size), '\0');
+        ZmqCompressor::decompress(codec, compressed.data(), size, &output[0], output.size(), stats);
+        EXPECT_EQ(output, data);
+        EXPECT_EQ(stats.messages, 2UL);
+        EXPECT_GT(stats.getRatio(), 1.0);
+
+        // A corrupted message doesn't decompress
+        compressed[size - 1] ^= 0x5a;
+        compressed[size / 2] ^= 0x5a;
+        EXPECT_THROW(ZmqCompressor::decompress(codec, compressed.data(), size, &output[0], output.size(), stats), runtime_error);
+        EXPECT_THROW(ZmqCompressor::decompressedSize(compressed.data(), 4), runtime_error);
+    }
+
+    // Data that doesn't shrink is sent as is
+    ZmqCompressionStats stats;
+    std::vector<char> compressed(ZmqCompressor::compressBound(ZmqCompression::LZ4, 4));
+    EXPECT_EQ(ZmqCompressor::compress(ZmqCompression::LZ4, "abcd", 4, compressed.data(), compressed.size(), stats), 0UL);
+}
+
+TEST(ZmqClientCompression, test)
+{
+    ZmqServer server("tcp://*:1241", "", false, 0, true);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "COMPRESSED_TABLE", &handler);
+
+    std::vector<KeyOpFieldsValuesTuple> routes;
+    for (int i = 0; i < 200; i++)
+    {
+        routes.emplace_back("route" + to_string(i), SET_COMMAND, std::vector<FieldValueTuple>{
+            {"SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION", "SAI_PACKET_ACTION_FORWARD"},
+            {"SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID", "oid:0x40000000" + to_string(i)} });
+    }
+
+    size_t expected = 0;
+    uint64_t serverMessages = 0;
+    for (auto codec : { ZmqCompression::LZ4, ZmqCompression::ZSTD })
+    {
+        ZmqClient client("tcp://localhost:1241", 3000, true);
+        EXPECT_EQ(client.getNegotiatedCompression(), ZmqCompression::NONE);
+        client.enableCompression(codec, 1024);
+        for (int i = 0; i < 300 && client.getNegotiatedCompression() != codec; i++)
+        {
+            usleep(10 * 1000);
+        }
+        ASSERT_EQ(client.getNegotiatedCompression(), codec);
+
+        // Small messages stay uncompressed
+        client.sendMsg(TEST_DB, "COMPRESSED_TABLE", { KeyOpFieldsValuesTuple("small", DEL_COMMAND, {}) });
+        EXPECT_EQ(client.getCompressionStats().messages, 0UL);
+
+        client.sendMsg(TEST_DB, "COMPRESSED_TABLE", routes);
+        auto stats = client.getCompressionStats();
+        EXPECT_EQ(stats.messages, 1UL);
+        EXPECT_GT(stats.getRatio(), 2.0);
+
+        expected += 1 + routes.size();
+        for (int i = 0; i < 300 && handler.keys().size() < expected; i++)
+        {
+            usleep(10 * 1000);
+        }
+        ASSERT_EQ(handler.keys().size(), expected);
+        EXPECT_EQ(handler.keys().back(), "route199");
+
+        serverMessages++;
+        EXPECT_EQ(server.getCompressionStats().messages, serverMessages);
+    }
+}
+
+TEST(ZmqClientWireFormat, negotiation)
+{
+    ZmqServer server("tcp://*:1241", "", false, 0, true);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "FORMAT_TABLE", &handler);
+
+    // V1 until the server confirmed it decodes V2, a PUSH client can't ask
+    ZmqClient push("tcp://localhost:1241");
+    EXPECT_EQ(push.getWireFormat(), BinarySerializer::Format::V1);
+
+    ZmqClient client("tcp://localhost:1241", 3000, true);
+    for (int i = 0; i < 300 && client.getWireFormat() != BinarySerializer::Format::V2_FIELD_DICTIONARY; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(client.getWireFormat(), BinarySerializer::Format::V2_FIELD_DICTIONARY);
+
+    // A set format is not negotiated
+    ZmqClient v1("tcp://localhost:1241", 3000, true);
+    v1.setWireFormat(BinarySerializer::Format::V1);
+    usleep(100 * 1000);
+    EXPECT_EQ(v1.getWireFormat(), BinarySerializer::Format::V1);
+
+    client.sendMsg(TEST_DB, "FORMAT_TABLE", { KeyOpFieldsValuesTuple("v2", DEL_COMMAND, {}) });
+    v1.sendMsg(TEST_DB, "FORMAT_TABLE", { KeyOpFieldsValuesTuple("v1", DEL_COMMAND, {}) });
+    for (int i = 0; i < 300 && handler.keys().size() < 2; i++)
+    {
+        usleep(10 * 1000);
+    }
+    auto keys = handler.keys();
+    EXPECT_EQ(std::set<string>(keys.begin(), keys.end()), (std::set<string>{ "v1", "v2" }));
+}
+
+TEST(ShmRing, wraparound)
+{
+    ShmRing producer(64 * 1024);
+    ShmRing consumer(dup(producer.getMemFd()), dup(producer.getDataEvent()), dup(producer.getSpaceEvent()));
+
+    // Odd sizes move the records around the end of the ring
+    for (size_t i = 0; i < 1000; i++)
+    {
+        std::string message(1000 + i * 7 % 3000, static_cast<char>('a' + i % 26));
+        char* buffer = producer.reserve(message.size(), 0);
+        ASSERT_NE(buffer, nullptr);
+        memcpy(buffer, message.data(), message.size());
+        producer.commit(message.size());
+
+        const char* data;
+        size_t size;
+        ASSERT_TRUE(consumer.front(data, size));
+        EXPECT_EQ(std::string(data, size), message);
+        consumer.pop();
+        EXPECT_FALSE(consumer.front(data, size));
+    }
+
+    // A full ring times out until the consumer frees space
+    size_t count = 0;
+    while (producer.reserve(8000, 0) != nullptr)
+    {
+        producer.commit(8000);
+        count++;
+    }
+    EXPECT_GT(count, 0UL);
+    EXPECT_EQ(producer.reserve(8000, 10), nullptr);
+
+    const char* data;
+    size_t size;
+    while (consumer.front(data, size))
+    {
+        EXPECT_EQ(size, 8000UL);
+        consumer.pop();
+        count--;
+    }
+    EXPECT_EQ(count, 0UL);
+    EXPECT_NE(producer.reserve(8000, 0), nullptr);
+}
+
+TEST(ShmRing, sealed)
+{
+    ShmRing producer(64 * 1024);
+    EXPECT_EQ(fcntl(producer.getMemFd(), F_GET_SEALS) & (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL),
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    EXPECT_NE(ftruncate(producer.getMemFd(), 4096), 0);
+
+    // A ring the producer could resize is not mapped
+    int memFd = memfd_create("swss-zmq-shm-ut", MFD_CLOEXEC);
+    ASSERT_GE(memFd, 0);
+    ASSERT_EQ(ftruncate(memFd, 4096 + 64 * 1024), 0);
+    EXPECT_THROW(ShmRing(memFd, eventfd(0, EFD_CLOEXEC), eventfd(0, EFD_CLOEXEC)), std::exception);
+}
+
+TEST(ZmqShmTransport, test)
+{
+    std::string endpoint = "shm:///tmp/zmq_shm_ut.sock";
+
+    // The client writes to the ring until the server takes it over
+    ZmqClient client(endpoint, 3000);
+    EXPECT_TRUE(client.isConnected());
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("early", DEL_COMMAND, {}) });
+
+    ZmqServer server(endpoint, "", false, 2);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "SHM_TABLE", &handler);
+
+    std::vector<KeyOpFieldsValuesTuple> routes;
+    for (int i = 0; i < 100; i++)
+    {
+        routes.emplace_back("route" + to_string(i), SET_COMMAND, std::vector<FieldValueTuple>{
+            {"SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID", "oid:0x40000000" + to_string(i)} });
+    }
+
+    // Waiting hands the ring over once the next attempt is allowed
+    std::string dbName, tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    uint64_t requestId = 0;
+    EXPECT_FALSE(client.wait(dbName, tableName, kcos, requestId, MQ_POLL_TIMEOUT + 100));
+
+    for (int i = 0; i < 50; i++)
+    {
+        client.sendMsg(TEST_DB, "SHM_TABLE", routes);
+    }
+    EXPECT_EQ(client.getLastRequestId(), 51UL);
+
+    size_t expected = 1 + 50 * routes.size();
+    for (int i = 0; i < 300 && handler.keys().size() < expected; i++)
+    {
+        usleep(10 * 1000);
+    }
+    ASSERT_EQ(handler.keys().size(), expected);
+    EXPECT_EQ(handler.keys().front(), "early");
+    EXPECT_EQ(handler.keys().back(), "route99");
+
+    // The response goes back over the unix socket
+    server.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("route99", SET_COMMAND, { FieldValueTuple("status", "0") }) });
+    ASSERT_TRUE(client.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 51UL);
+    EXPECT_EQ(tableName, "SHM_TABLE");
+    ASSERT_EQ(kcos.size(), 1UL);
+    EXPECT_EQ(kfvKey(*kcos[0]), "route99");
+    EXPECT_EQ(client.getOutstandingRequestCount(), 0UL);
+
+    // Nothing to compress on shared memory
+    client.enableCompression(ZmqCompression::LZ4);
+    EXPECT_EQ(client.getNegotiatedCompression(), ZmqCompression::NONE);
+}
+
+TEST(ZmqShmTransport, restart)
+{
+    std::string endpoint = "shm:///tmp/zmq_shm_ut.sock";
+    std::unique_ptr<ZmqServer> first(new ZmqServer(endpoint));
+    ZmqClient client(endpoint, 3000);
+    auto waitKeys = [](SlowZmqHandler& handler, size_t count) {
+        for (int i = 0; i < 300 && handler.keys().size() < count; i++)
+        {
+            usleep(10 * 1000);
+        }
+        return handler.keys();
+    };
+
+    {
+        SlowZmqHandler handler(0);
+        first->registerMessageHandler(TEST_DB, "SHM_TABLE", &handler);
+        client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k1", DEL_COMMAND, {}) });
+        EXPECT_EQ(waitKeys(handler, 1), (vector<string>{ "k1" }));
+        first.reset();
+    }
+
+    // The next send sees the server went away and hands the ring over to the new one
+    ZmqServer server(endpoint);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "SHM_TABLE", &handler);
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k2", DEL_COMMAND, {}) });
+    EXPECT_EQ(waitKeys(handler, 1), (vector<string>{ "k2" }));
+}
+
+TEST(ZmqShmTransport, reconnect_rate)
+{
+    std::string endpoint = "shm:///tmp/zmq_shm_ut.sock";
+
+    // The failed attempt of the constructor holds the next one back
+    ZmqClient client(endpoint, 3000);
+    ZmqServer server(endpoint);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "SHM_TABLE", &handler);
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k1", DEL_COMMAND, {}) });
+    EXPECT_LT(client.m_shmSocket, 0);
+
+    // The ring is handed over once the attempts are allowed again
+    usleep((MQ_POLL_TIMEOUT + 100) * 1000);
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k2", DEL_COMMAND, {}) });
+    EXPECT_GE(client.m_shmSocket, 0);
+    for (int i = 0; i < 300 && handler.keys().size() < 2; i++)
+    {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(handler.keys(), (vector<string>{ "k1", "k2" }));
+}
+
+TEST(ZmqShmTransport, large_response)
+{
+    std::string endpoint = "shm:///tmp/zmq_shm_ut.sock";
+    ZmqServer server(endpoint);
+    ZmqClient client(endpoint, 3000);
+    SlowZmqHandler handler(0);
+    server.registerMessageHandler(TEST_DB, "SHM_TABLE", &handler);
+    auto waitKeys = [&handler](size_t count) {
+        for (int i = 0; i < 300 && handler.keys().size() < count; i++)
+        {
+            usleep(10 * 1000);
+        }
+        return handler.keys().size();
+    };
+
+    // A response far bigger than the socket buffer, the next one is queued behind its tail
+    std::string value(4 * 1024 * 1024, 'x');
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k1", DEL_COMMAND, {}) });
+    ASSERT_EQ(waitKeys(1), 1UL);
+    server.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k1", SET_COMMAND, { FieldValueTuple("status", value) }) });
+    client.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k2", DEL_COMMAND, {}) });
+    ASSERT_EQ(waitKeys(2), 2UL);
+    server.sendMsg(TEST_DB, "SHM_TABLE", { KeyOpFieldsValuesTuple("k2", SET_COMMAND, { FieldValueTuple("status", "0") }) });
+
+    std::string dbName, tableName;
+    std::vector<std::shared_ptr<KeyOpFieldsValuesTuple>> kcos;
+    uint64_t requestId = 0;
+    ASSERT_TRUE(client.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 1UL);
+    ASSERT_EQ(kcos.size(), 1UL);
+    EXPECT_EQ(kfvKey(*kcos[0]), "k1");
+    ASSERT_EQ(kfvFieldsValues(*kcos[0]).size(), 1UL);
+    EXPECT_EQ(fvValue(kfvFieldsValues(*kcos[0])[0]), value);
+
+    ASSERT_TRUE(client.wait(dbName, tableName, kcos, requestId, 3000));
+    EXPECT_EQ(requestId, 2UL);
+    ASSERT_EQ(kcos.size(), 1UL);
+    EXPECT_EQ(kfvKey(*kcos[0]), "k2");
+}